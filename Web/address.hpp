@@ -0,0 +1,249 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <boost/asio/ip/address.hpp>
+#include <boost/asio/ip/address_v4.hpp>
+#include <boost/asio/ip/address_v6.hpp>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <compare>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "marcos.hpp"
+
+
+namespace bulgogi {
+
+    /**
+     * @brief Address of the connected client, as passed to handlers as `remote_ip`.
+     *
+     * Holds the `boost::asio::ip::address` taken from the socket; the text form is only rendered
+     * the first time it is asked for, so connections whose handlers never look at it do not
+     * pay for `to_string()`. For handlers written against the former `const std::string &remote_ip`
+     * parameter it keeps the text operations they used: it converts to `const std::string &` and
+     * `std::string_view`, compares with strings, streams, concatenates with `+`, and forwards
+     * `size()`, `empty()`, `data()` and `c_str()` to `str()`.
+     *
+     * An IPv4 client on a dual-stack listener appears as IPv4, not as `::ffff:a.b.c.d`.
+     */
+    class remote_address {
+        boost::asio::ip::address address_;
+        mutable std::string text_;
+        bool known_ = false;
+
+    public:
+        /// @brief Unknown address (e.g. the peer disconnected before it could be read); `str()` is empty.
+        remote_address() = default;
+
+        explicit remote_address(const boost::asio::ip::address &address) : known_(true) {
+            if (address.is_v6() && address.to_v6().is_v4_mapped()) {
+                address_ = boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, address.to_v6());
+            } else {
+                address_ = address;
+            }
+        }
+
+        [[nodiscard]] const boost::asio::ip::address &address() const noexcept { return address_; }
+
+        [[nodiscard]] bool known() const noexcept { return known_; }
+
+        /// @brief Dotted or colon notation, rendered on first use; empty when unknown.
+        [[nodiscard]] const std::string &str() const {
+            if (known_ && text_.empty()) text_ = address_.to_string();
+            return text_;
+        }
+
+        [[nodiscard]] std::size_t size() const { return str().size(); }
+
+        [[nodiscard]] bool empty() const { return str().empty(); }
+
+        [[nodiscard]] const char *data() const { return str().data(); }
+
+        [[nodiscard]] const char *c_str() const { return str().c_str(); }
+
+        operator const std::string &() const { return str(); }  // NOLINT(google-explicit-constructor)
+
+        operator std::string_view() const { return str(); }  // NOLINT(google-explicit-constructor)
+
+        friend bool operator==(const remote_address &a, std::string_view text) { return a.str() == text; }
+
+        friend std::strong_ordering operator<=>(const remote_address &a, std::string_view text) {
+            return std::string_view(a.str()) <=> text;
+        }
+
+        friend std::ostream &operator<<(std::ostream &os, const remote_address &a) { return os << a.str(); }
+
+        friend std::string operator+(const remote_address &a, std::string_view text) {
+            std::string out = a.str();
+            out += text;
+            return out;
+        }
+
+        friend std::string operator+(std::string_view text, const remote_address &a) {
+            std::string out(text);
+            out += a.str();
+            return out;
+        }
+    };
+
+    /**
+     * @brief A precompiled set of IPv4 and IPv6 networks in CIDR notation.
+     *
+     * Networks are stored as sorted, merged `[first, last]` address ranges per family, so a
+     * lookup is a binary search over raw address bytes without parsing or allocating.
+     * IPv4-mapped IPv6 addresses are matched against the IPv4 networks.
+     *
+     * @code{.cpp}
+     * static const bulgogi::cidr_set office{"10.20.0.0/16", "2001:db8:42::/48"};
+     * if (!office.contains(remote_ip.address())) return bulgogi::set_text(res, "Forbidden", 403);
+     * @endcode
+     *
+     * Build sets before serving; `add` is not safe against concurrent `contains`.
+     */
+    class cidr_set {
+        template<typename Bytes>
+        struct range {
+            Bytes first;
+            Bytes last;
+        };
+
+        using v4_bytes = boost::asio::ip::address_v4::bytes_type;
+        using v6_bytes = boost::asio::ip::address_v6::bytes_type;
+
+        std::vector<range<v4_bytes>> v4_;
+        std::vector<range<v6_bytes>> v6_;
+
+        template<typename Bytes>
+        static range<Bytes> network(const Bytes &address, unsigned prefix) {
+            range<Bytes> r{address, address};
+            for (std::size_t i = 0; i < address.size(); ++i) {
+                const unsigned bits = prefix > i * 8 ? std::min(8u, prefix - static_cast<unsigned>(i * 8)) : 0;
+                const auto mask = static_cast<unsigned char>(bits == 0 ? 0 : 0xFFu << (8 - bits));
+                r.first[i] = static_cast<unsigned char>(address[i] & mask);
+                r.last[i] = static_cast<unsigned char>(address[i] | static_cast<unsigned char>(~mask));
+            }
+            return r;
+        }
+
+        template<typename Bytes>
+        static void insert(std::vector<range<Bytes>> &ranges, const range<Bytes> &r) {
+            ranges.push_back(r);
+            std::sort(ranges.begin(), ranges.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            std::vector<range<Bytes>> merged;
+            merged.reserve(ranges.size());
+            for (const auto &next: ranges) {
+                if (!merged.empty() && next.first <= merged.back().last) {
+                    merged.back().last = std::max(merged.back().last, next.last);
+                } else {
+                    merged.push_back(next);
+                }
+            }
+            ranges.swap(merged);
+        }
+
+        template<typename Bytes>
+        static bool lookup(const std::vector<range<Bytes>> &ranges, const Bytes &address) noexcept {
+            // First range starting after the address; the candidate is the one before it
+            const auto it = std::upper_bound(ranges.begin(), ranges.end(), address,
+                                             [](const Bytes &a, const range<Bytes> &r) { return a < r.first; });
+            return it != ranges.begin() && address <= std::prev(it)->last;
+        }
+
+    public:
+        cidr_set() = default;
+
+        /// @throws std::invalid_argument on a malformed network.
+        cidr_set(std::initializer_list<std::string_view> networks) {
+            for (const auto network: networks) add(network);
+        }
+
+        /**
+         * @brief Add a network such as `10.0.0.0/8`, `fd00::/8` or a single address (`::1`).
+         * @throws std::invalid_argument on a malformed address or prefix length.
+         */
+        void add(std::string_view cidr) {
+            const auto slash = cidr.find('/');
+            boost::system::error_code ec;
+            const auto address = boost::asio::ip::make_address(std::string(cidr.substr(0, slash)), ec);
+            const unsigned max_prefix = address.is_v4() ? 32 : 128;
+            unsigned prefix = max_prefix;
+            if (!ec && slash != std::string_view::npos) {
+                const auto text = cidr.substr(slash + 1);
+                const auto [ptr, parse_ec] = std::from_chars(text.data(), text.data() + text.size(), prefix);
+                if (text.empty() || parse_ec != std::errc{} || ptr != text.data() + text.size()) prefix = max_prefix + 1;
+            }
+            if (ec || prefix > max_prefix) {
+                throw std::invalid_argument("cidr_set: invalid network '" + std::string(cidr) + "'");
+            }
+            if (address.is_v4()) insert(v4_, network(address.to_v4().to_bytes(), prefix));
+            else insert(v6_, network(address.to_v6().to_bytes(), prefix));
+        }
+
+        [[nodiscard]] bool empty() const noexcept { return v4_.empty() && v6_.empty(); }
+
+        [[nodiscard]] bool contains(const boost::asio::ip::address &address) const noexcept {
+            if (address.is_v4()) return lookup(v4_, address.to_v4().to_bytes());
+            const auto v6 = address.to_v6();
+            if (v6.is_v4_mapped()) {
+                return lookup(v4_, boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, v6).to_bytes());
+            }
+            return lookup(v6_, v6.to_bytes());
+        }
+
+        /// @brief False for unknown addresses.
+        [[nodiscard]] bool contains(const remote_address &address) const noexcept {
+            return address.known() && contains(address.address());
+        }
+
+        /// @brief Parse @p text and look it up; false if it is not an address.
+        [[nodiscard]] bool contains(const std::string &text) const noexcept {
+            boost::system::error_code ec;
+            const auto address = boost::asio::ip::make_address(text, ec);
+            return !ec && contains(address);
+        }
+    };
+
+    /**
+     * @brief Networks treated as internal by `ipv4::is_internal_network` (and so by
+     *        `/shutdown_server`, `/server_stats` and `/metrics`).
+     *
+     * Built on first use from `INTERNAL_NETWORKS`, a comma-separated list of networks; when that
+     * is empty, from `127.0.0.1`, `0.0.0.0`, `10.0.0.0/8`, `172.16.0.0/12`, `192.168.0.0/16` and
+     * `::1`. It can also be extended in `views::init()`, before the server accepts connections:
+     * @code{.cpp}
+     * void views::init() {
+     *     bulgogi::internal_networks().add("100.64.0.0/10");  // VPN
+     * }
+     * @endcode
+     *
+     * @throws std::invalid_argument on first use if `INTERNAL_NETWORKS` holds a malformed network.
+     */
+    inline cidr_set &internal_networks() {
+        static cidr_set networks = [] {
+            constexpr std::string_view configured = INTERNAL_NETWORKS;
+            if (configured.empty()) {
+                return cidr_set{"127.0.0.1", "0.0.0.0", "10.0.0.0/8", "172.16.0.0/12", "192.168.0.0/16", "::1"};
+            }
+            cidr_set set;
+            std::size_t begin = 0;
+            while (begin <= configured.size()) {
+                const auto end = std::min(configured.find(',', begin), configured.size());
+                auto entry = configured.substr(begin, end - begin);
+                while (!entry.empty() && entry.front() == ' ') entry.remove_prefix(1);
+                while (!entry.empty() && entry.back() == ' ') entry.remove_suffix(1);
+                if (!entry.empty()) set.add(entry);
+                begin = end + 1;
+            }
+            return set;
+        }();
+        return networks;
+    }
+}
@@ -6,9 +6,17 @@
 #include <boost/beast/http.hpp>
 #include <boost/json.hpp>
 #include <boost/asio/ip/address_v4.hpp>
+#include <charconv>
 #include <regex>
+#include <functional>
+#include <limits>
+#include <optional>
 #include <jh/pod>
 #include "marcos.hpp"
+#include "address.hpp"
+#include "query.hpp"
+#include "json_writer.hpp"
+#include "json_document.hpp"
 
 
 namespace bulgogi {
@@ -16,6 +24,7 @@ namespace bulgogi {
     namespace http = beast::http;
     using Request = http::request<http::string_body>;
     using Response = http::response<http::string_body>;
+    using QueryView = query_view;
 }
 
 namespace bulgogi::cors {
@@ -26,19 +35,22 @@ namespace bulgogi::cors {
 namespace bulgogi::ipv4 {
 
     namespace detail {
-        inline bool parse_ipv4_strict(const std::string& ip, uint8_t& a, uint8_t& b, uint8_t& c, uint8_t& d) {
-            size_t pos = 0, last = 0;
+        /// @brief Parse dotted-quad IPv4 (`a.b.c.d`, 1-3 decimal digits per octet) without allocating.
+        inline bool parse_ipv4_strict(std::string_view ip, uint8_t& a, uint8_t& b, uint8_t& c, uint8_t& d) {
             unsigned int values[4] = {0};
+            const char *p = ip.data();
+            const char *const end = ip.data() + ip.size();
 
             for (int i = 0; i < 4; ++i) {
-                pos = ip.find('.', last);
-                std::string token = (i < 3) ? ip.substr(last, pos - last) : ip.substr(last);
-                char* end;
-                auto val = std::strtoul(token.c_str(), &end, 10);
-                if (*end != '\0' || val > 255) return false;
-                values[i] = val;
-                last = pos + 1;
+                if (i > 0) {
+                    if (p == end || *p != '.') return false;
+                    ++p;
+                }
+                const auto [next, ec] = std::from_chars(p, end, values[i]);
+                if (ec != std::errc{} || next - p > 3 || values[i] > 255) return false;
+                p = next;
             }
+            if (p != end) return false;
 
             a = static_cast<uint8_t>(values[0]);
             b = static_cast<uint8_t>(values[1]);
@@ -69,11 +81,25 @@ namespace bulgogi::ipv4 {
     }
 
     /**
-     * @brief Check if the given IP belongs to the local/private LAN.
-     * IPv6 is explicitly excluded. Only IPv4 loop-back or private subnets are accepted.
+     * @brief Check if the client address is in `bulgogi::internal_networks()`
+     *        (loop-back and private LAN by default).
+     * This is the overload handlers hit with `remote_ip`: no parsing, no allocation.
+     */
+    inline bool is_internal_network(const remote_address &ip) {
+        return internal_networks().contains(ip);
+    }
+
+    /// @brief As above, for an address taken from the socket.
+    inline bool is_internal_network(const boost::asio::ip::address &ip) {
+        return internal_networks().contains(ip);
+    }
+
+    /**
+     * @brief As above, for an address in text form (e.g. from a trusted `X-Forwarded-For`).
+     * Text that is not an IPv4 or IPv6 address is never internal.
      */
     inline bool is_internal_network(const std::string &ip) {
-        return is_self(ip) || is_private_lan_ip(ip);
+        return internal_networks().contains(ip);
     }
 }
 
@@ -107,6 +133,25 @@ namespace bulgogi {
         res.prepare_payload();
     }
 
+    /**
+     * @brief Finish a response whose JSON body was written with a `json_writer`.
+     *
+     * If the writer targeted `res.body()` nothing is copied; otherwise its buffer is moved into
+     * the body.
+     *
+     * @param res Response to populate.
+     * @param writer Writer holding a complete JSON document.
+     * @param status_code HTTP status code (default: 200).
+     * @throws std::logic_error if the document still has unclosed objects/arrays.
+     */
+    inline void set_json(Response &res, json_writer &writer, int status_code = 200) {
+        if (!writer.complete()) throw std::logic_error("set_json: incomplete JSON document");
+        if (&writer.str() != &res.body()) res.body() = std::move(writer.str());
+        res.result(http::status(status_code));
+        res.set(http::field::content_type, "application/json");
+        res.prepare_payload();
+    }
+
     /**
      * @brief Set response as plain text body.
      * @param res Response to populate.
@@ -133,6 +178,57 @@ namespace bulgogi {
         res.prepare_payload();
     }
 
+    /**
+     * @brief Body producer for streamed responses.
+     *
+     * Called repeatedly with a buffer of `STREAM_BUFFER_SIZE` bytes; it writes the next piece of
+     * the body into it and returns how many bytes it wrote. Returning 0 ends the body.
+     * It runs on the connection's I/O thread between socket writes, so it should not block for
+     * long. Throwing aborts the connection (the status line has already been sent).
+     */
+    using stream_producer = std::function<std::size_t(char *buffer, std::size_t capacity)>;
+
+    namespace detail {
+        struct pending_stream {
+            stream_producer producer;
+            std::optional<std::uint64_t> content_length;
+        };
+
+        /// @brief Hand-off from `set_stream` to the session that called the handler (same thread).
+        inline std::optional<pending_stream> &stream_slot() {
+            thread_local std::optional<pending_stream> slot;
+            return slot;
+        }
+    }
+
+    /**
+     * @brief Stream the response body from a producer instead of materialising it.
+     *
+     * The server writes the headers, then pulls the body through @p producer one bounded buffer at
+     * a time, so a large export never has to be resident in memory. With @p content_length the
+     * body is sent with `Content-Length` (a producer that ends early or runs over aborts the
+     * connection); without it the body is sent with chunked transfer encoding (close-delimited for
+     * HTTP/1.0 clients). `HEAD` requests get the headers only.
+     *
+     * This must be the last call that touches @p res in the handler; if a body is set afterwards
+     * the stream is dropped.
+     *
+     * @param res Response to populate.
+     * @param producer Body producer, see `stream_producer`.
+     * @param content_type Value of the `Content-Type` header.
+     * @param content_length Exact body size if known up front.
+     * @param status_code HTTP status code (default: 200).
+     */
+    inline void set_stream(Response &res, stream_producer producer, std::string_view content_type,
+                           std::optional<std::uint64_t> content_length = std::nullopt, int status_code = 200) {
+        res.result(http::status(status_code));
+        res.set(http::field::content_type, content_type);
+        res.body().clear();
+        if (content_length) res.content_length(*content_length);
+        else res.chunked(true);
+        detail::stream_slot() = detail::pending_stream{std::move(producer), content_length};
+    }
+
     /**
      * @brief Set response as binary file download (octet-stream).
      * @param res Response to populate.
@@ -147,6 +243,19 @@ namespace bulgogi {
         res.prepare_payload();
     }
 
+    /**
+     * @brief Stream a binary file download (octet-stream) from a producer, see `set_stream`.
+     * @param res Response to populate.
+     * @param producer Body producer.
+     * @param filename Download file name (Content-Disposition header).
+     * @param content_length Exact size if known; chunked otherwise.
+     */
+    [[maybe_unused]] inline void set_binary(Response &res, stream_producer producer, const std::string &filename,
+                                            std::optional<std::uint64_t> content_length = std::nullopt) {
+        res.set(http::field::content_disposition, "attachment; filename=\"" + filename + "\"");
+        set_stream(res, std::move(producer), "application/octet-stream", content_length);
+    }
+
     /**
      * @tparam Mime MIME type tag (e.g., "csv", "yaml") as jh::pod::array.
      * @brief Set response as downloadable text file with specific MIME type.
@@ -185,8 +294,79 @@ namespace bulgogi {
             res.body() = std::string(content);
             res.prepare_payload();
         }
+
+        /// @brief Streamed variant of `apply`, see `set_stream`.
+        [[maybe_unused]]
+        static void apply(Response &res, stream_producer producer, const std::string &filename, // NOLINT
+                          std::optional<std::uint64_t> content_length = std::nullopt) {
+            res.set(http::field::content_disposition, "attachment; filename=\"" + filename + "\"");
+            set_stream(res, std::move(producer), "text/" + std::string(Mime.data), content_length);
+        }
     };
 
+    /// @brief Body limit for `REGISTER_BODY_LIMIT` / `REGISTER_STREAMING_BODY` that accepts any size.
+    inline constexpr std::uint64_t unlimited_body = std::numeric_limits<std::uint64_t>::max();
+
+    /**
+     * @brief Request body consumer for `receive_body`.
+     *
+     * Called with each piece of the body as it is read, at most `STREAM_BUFFER_SIZE` bytes at a
+     * time; the view is only valid during the call. It runs on the connection's I/O thread
+     * between socket reads, so it should not block for long. Throwing is answered like a throwing
+     * handler, and the connection is closed if the body was not read to the end.
+     */
+    using body_consumer = std::function<void(std::string_view piece)>;
+
+    /// @brief Called once the whole body went through the consumer, to complete the response.
+    using body_complete = std::function<void(Response &res)>;
+
+    namespace detail {
+        struct pending_body {
+            body_consumer consumer;
+            body_complete complete;
+        };
+
+        /// @brief Hand-off from `receive_body` to the session that called the handler (same thread).
+        inline std::optional<pending_body> &body_slot() {
+            thread_local std::optional<pending_body> slot;
+            return slot;
+        }
+    }
+
+    /**
+     * @brief Take the request body piece by piece instead of from `req.body()`.
+     *
+     * On routes declared with `REGISTER_STREAMING_BODY` the handler is called as soon as the
+     * headers are in, with an empty `req.body()`. Calling `receive_body` asks the server to read
+     * the body and pass it to @p consumer one bounded buffer at a time, so an upload never has to
+     * fit in memory; @p complete is then called with the response the handler left in `res` and
+     * finishes it (it may also call `set_stream`). A client sending `Expect: 100-continue` only
+     * gets its `100 Continue` at that point, so a handler that answers without calling
+     * `receive_body` (e.g. `401`) rejects the upload before it is sent; the connection is then
+     * closed instead of reading the unwanted body.
+     *
+     * On other routes the body has already been read into `req.body()`; it is passed to
+     * @p consumer in one piece, followed by @p complete.
+     *
+     * @code{.cpp}
+     * REGISTER_VIEW(upload) {
+     *     if (!check_method(req, bulgogi::http::verb::put, res)) return;
+     *     auto file = std::make_shared<std::ofstream>("/srv/upload.bin", std::ios::binary);
+     *     auto size = std::make_shared<std::uint64_t>(0);
+     *     bulgogi::receive_body(
+     *             [file, size](std::string_view piece) { file->write(piece.data(), piece.size()); *size += piece.size(); },
+     *             [size](bulgogi::Response &res) { bulgogi::set_json(res, {{"stored", *size}}, 201); });
+     * }
+     * REGISTER_STREAMING_BODY(8ull << 30, "upload");  // up to 8 GiB
+     * @endcode
+     *
+     * If the body cannot be read completely (client gone, over the limit, timeout) @p complete is
+     * never called and both functions are destroyed.
+     */
+    inline void receive_body(body_consumer consumer, body_complete complete) {
+        detail::body_slot() = detail::pending_body{std::move(consumer), std::move(complete)};
+    }
+
     /**
      * @brief Parse and return JSON object from request body.
      * @param req Request with JSON body.
@@ -197,6 +377,27 @@ namespace bulgogi {
         return boost::json::parse(req.body()).as_object();
     }
 
+    /**
+     * @brief Parse the JSON request body into the calling thread's reusable arena.
+     *
+     * Unlike `get_json_obj`, no node is allocated on the global heap once the per-thread buffer
+     * has grown to fit typical bodies, and nothing is deep-copied on return. The result is only
+     * valid inside the current handler call.
+     *
+     * @code{.cpp}
+     * const auto doc = bulgogi::get_json_doc(req);
+     * const auto &obj = doc.object();
+     * std::string_view name = obj.at("name").as_string();
+     * @endcode
+     *
+     * @param req Request with JSON body.
+     * @return Document owning the parsed value for the duration of the request.
+     * @throws boost::json::system_error on invalid JSON.
+     */
+    [[maybe_unused]] inline json_document get_json_doc(const Request &req) {
+        return json_document{req.body()};
+    }
+
     /**
      * @brief Convert HTTP verb to string representation.
      * @param method HTTP verb.
@@ -220,6 +421,20 @@ namespace bulgogi {
         res.prepare_payload();
     }
 
+    namespace detail {
+        /// @brief Render verbs as `GET, POST`, optionally followed by `, OPTIONS`.
+        inline std::string join_methods(std::initializer_list<http::verb> methods, bool with_options = false) {
+            std::string out;
+            out.reserve(methods.size() * 8 + 9);
+            for (const http::verb v: methods) {
+                if (!out.empty()) out += ", ";
+                out += http::to_string(v);
+            }
+            if (with_options) out += out.empty() ? "OPTIONS" : ", OPTIONS";  // preflight
+            return out;
+        }
+    }
+
     /**
      * @brief Set CORS headers for response.
      * @param res Response to modify.
@@ -241,13 +456,7 @@ namespace bulgogi {
         res.set(http::field::access_control_allow_origin, allow_origin);
 
         if (allowed_methods.size()) {
-            std::ostringstream oss;
-            for (auto it = allowed_methods.begin(); it != allowed_methods.end(); ++it) {
-                oss << http::to_string(*it);
-                if (std::next(it) != allowed_methods.end()) oss << ", ";
-            }
-            oss << ", " << http::to_string(http::verb::options);  // preflight
-            res.set(http::field::access_control_allow_methods, oss.str());
+            res.set(http::field::access_control_allow_methods, detail::join_methods(allowed_methods, true));
         }
 
         res.set(http::field::access_control_allow_headers, "Content-Type, Authorization");
@@ -353,14 +562,7 @@ namespace bulgogi {
         if (!allowed) {
             set_json(res, {
                     {"error",    "Method Not Allowed"},
-                    {"expected", [allowed_methods] {
-                        std::ostringstream oss;
-                        for (auto it = allowed_methods.begin(); it != allowed_methods.end(); ++it) {
-                            oss << http::to_string(*it);
-                            if (std::next(it) != allowed_methods.end()) oss << ", ";
-                        }
-                        return oss.str();
-                    }()},
+                    {"expected", detail::join_methods(allowed_methods)},
                     {"got",      http::to_string(req_method)}
             }, 405);
 
@@ -392,37 +594,81 @@ namespace bulgogi {
         return check_method(req, {allowed_method}, res, allow_origin, credentials);
     }
 
+    /**
+     * @brief Parse the query string of a request once for repeated lookups.
+     * @param req HTTP request with URL.
+     * @return View over the request target; must not outlive @p req.
+     * @example
+     * @code{.cpp}
+     * const auto query = bulgogi::get_query(req);
+     * auto page = query.get<std::int64_t>("page").value_or(1);
+     * auto verbose = query.get<bool>("verbose").value_or(false);
+     * std::string_view name = query.get("name").value_or("anonymous");
+     * @endcode
+     */
+    [[maybe_unused]] inline QueryView get_query(const Request &req) {
+        return QueryView{req.target()};
+    }
+
     /**
      * @brief Extract query string parameter from URL.
+     *
+     * Kept for compatibility as a thin wrapper over `QueryView::raw`: keys are matched decoded,
+     * but the value is returned exactly as it appears in the target, without percent/`+`
+     * decoding. Prefer `get_query(req)` for decoded values or when reading more than one
+     * parameter, as this parses the target on every call.
+     *
      * @param req HTTP request with URL.
      * @param key Name of the query parameter.
-     * @return Value if key exists; std::nullopt otherwise.
+     * @return Raw value if key exists; std::nullopt otherwise.
      */
     [[maybe_unused]] inline std::optional<std::string> get_query_param(
             const boost::beast::http::request<boost::beast::http::string_body> &req,
             std::string_view key) {
-        const std::string target = std::string(req.target());
-        const std::string_view target_view = target;
-        std::string_view query = target_view.substr(target.find('?') + 1); // query = view from owned string
-
-        while (!query.empty()) {
-            auto eq = query.find('=');
-            if (eq == std::string_view::npos) break;
-
-            std::string_view k = query.substr(0, eq);
-            query.remove_prefix(eq + 1);
+        if (const auto value = QueryView{req.target()}.raw(key)) return std::string(*value);
+        return std::nullopt;
+    }
 
-            auto amp = query.find('&');
-            std::string_view v = (amp == std::string_view::npos) ? query : query.substr(0, amp);
-            if (amp != std::string_view::npos) query.remove_prefix(amp + 1);
-            else query = {};
+    /**
+     * @brief Check whether the client accepts a content coding.
+     *
+     * Parses `Accept-Encoding` as a list of codings with optional `q` weights; a coding listed
+     * with `q=0` is refused, and `*` stands for any coding not listed explicitly.
+     *
+     * @param req Incoming HTTP request.
+     * @param coding Lower-case coding name such as `"gzip"` or `"br"`.
+     * @return true if @p coding may be used for the response body.
+     */
+    [[maybe_unused]] inline bool accepts_encoding(const Request &req, std::string_view coding) {
+        std::string_view header = req[http::field::accept_encoding];
+        std::optional<bool> wildcard;
+        while (!header.empty()) {
+            const auto comma = header.find(',');
+            std::string_view item = header.substr(0, comma);
+            header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+            const auto semi = item.find(';');
+            std::string_view name = item.substr(0, semi);
+            while (!name.empty() && name.front() == ' ') name.remove_prefix(1);
+            while (!name.empty() && name.back() == ' ') name.remove_suffix(1);
+
+            bool allowed = true;
+            if (semi != std::string_view::npos) {
+                std::string_view params = item.substr(semi + 1);
+                while (!params.empty() && params.front() == ' ') params.remove_prefix(1);
+                if (params.starts_with("q=") || params.starts_with("Q=")) {
+                    params.remove_prefix(2);
+                    allowed = params.find_first_not_of("0. ") != std::string_view::npos;
+                }
+            }
 
-            if (k == key) {
-                return std::string(v); // NOLINT(clang-analyzer-cplusplus.NewDeleteLeaks)
-                // safe: v from target_view, local variable
+            if (name.size() == coding.size() &&
+                std::equal(name.begin(), name.end(), coding.begin(), [](char a, char b) { return (a | 0x20) == b; })) {
+                return allowed;
             }
+            if (name == "*") wildcard = allowed;
         }
-        return std::nullopt;
+        return wildcard.value_or(false);
     }
 
 }
@@ -0,0 +1,107 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <boost/asio/buffer.hpp>
+#include <array>
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "bulgogi.hpp"
+
+
+namespace bulgogi {
+
+    /**
+     * @brief A response serialized once into wire-ready bytes.
+     *
+     * The status line and headers are rendered at construction, in every variant the server may
+     * need: with no `Connection` header, `Connection: close` or `Connection: keep-alive`. Answering
+     * a request is then a single gathered socket write of one header block, an optional per-request
+     * header line (the response cache's `Age`) and the body (none for `HEAD`), with no handler call,
+     * formatting or allocation. The body is stored once.
+     *
+     * The status line always says `HTTP/1.1`, which is also what HTTP/1.0 clients are answered
+     * with by servers that speak 1.1. `Content-Length` is derived from the body and any
+     * `Connection` / `Content-Length` header on the source response is ignored.
+     *
+     * The header fields (names lower-cased) and body are also kept apart for transports that
+     * frame messages themselves, such as HTTP/2.
+     */
+    class canned_response {
+        enum connection : std::size_t { implicit, close, keep_alive };
+
+        std::array<std::string, 3> head_;  // status line and headers, without the blank line
+        std::vector<std::pair<std::string, std::string>> fields_;
+        std::string body_ = "\r\n";  // the blank line ending the headers, then the body
+        unsigned status_ = 0;
+
+    public:
+        canned_response() = default;
+
+        /// @brief Freeze @p res (status, headers and body) as it is now.
+        explicit canned_response(const Response &res) {
+            status_ = res.result_int();
+            const unsigned status = status_;
+            const bool bodyless = status < 200 || status == 204 || status == 304;
+
+            std::string header = "HTTP/1.1 " + std::to_string(status) + " " + std::string(res.reason()) + "\r\n";
+            for (const auto &field: res) {
+                if (field.name() == http::field::connection || field.name() == http::field::content_length) continue;
+                header.append(field.name_string()).append(": ").append(field.value()).append("\r\n");
+                std::string name(field.name_string());
+                for (auto &c: name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                fields_.emplace_back(std::move(name), std::string(field.value()));
+            }
+            if (!bodyless) {
+                header += "Content-Length: " + std::to_string(res.body().size()) + "\r\n";
+                fields_.emplace_back("content-length", std::to_string(res.body().size()));
+                body_ += res.body();
+            }
+
+            static constexpr std::string_view connection_lines[] = {
+                    "", "Connection: close\r\n", "Connection: keep-alive\r\n"};
+            for (std::size_t i = 0; i < 3; ++i) {
+                head_[i] = header;
+                head_[i].append(connection_lines[i]);
+            }
+        }
+
+        [[nodiscard]] unsigned status() const noexcept { return status_; }
+
+        /**
+         * @brief Buffers to write for a request: the headers, @p extra and the body.
+         * @param head True for `HEAD` requests (only the blank line follows the headers).
+         * @param version Request version (10 or 11).
+         * @param keep_alive Whether the connection stays open after this response.
+         * @param extra Complete header lines (each ending in `\r\n`) added for this request only;
+         *              they must stay alive until the write completes.
+         */
+        [[nodiscard]] std::array<boost::asio::const_buffer, 3> wire(bool head, unsigned version, bool keep_alive,
+                                                                   std::string_view extra = {}) const noexcept {
+            connection c;
+            if (version >= 11) c = keep_alive ? implicit : close;
+            else c = keep_alive ? connection::keep_alive : close;
+            const std::string_view rest = body_;
+            return {boost::asio::buffer(head_[c]), boost::asio::buffer(extra),
+                    boost::asio::buffer(head ? rest.substr(0, 2) : rest)};
+        }
+
+        /// @brief Approximate bytes held by this object, for caches that bound their memory.
+        [[nodiscard]] std::size_t footprint() const noexcept {
+            std::size_t bytes = sizeof(*this) + body_.size();
+            for (const auto &h: head_) bytes += h.size();
+            for (const auto &[name, value]: fields_) bytes += name.size() + value.size() + sizeof(fields_[0]);
+            return bytes;
+        }
+
+        /// @brief Header fields with lower-case names, including `content-length`.
+        [[nodiscard]] const std::vector<std::pair<std::string, std::string>> &fields() const noexcept { return fields_; }
+
+        /// @brief The body alone; empty for bodyless statuses.
+        [[nodiscard]] std::string_view body() const noexcept { return std::string_view(body_).substr(2); }
+    };
+}
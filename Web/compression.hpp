@@ -0,0 +1,282 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <zlib.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bulgogi.hpp"
+#include "marcos.hpp"
+
+#if BULGOGI_BROTLI
+#include <brotli/encode.h>
+#endif
+
+
+namespace bulgogi::compression {
+
+    enum class coding { identity, br, gzip, deflate };
+
+    [[nodiscard]] inline std::string_view name_of(coding c) noexcept {
+        switch (c) {
+            case coding::br: return "br";
+            case coding::gzip: return "gzip";
+            case coding::deflate: return "deflate";
+            default: return "identity";
+        }
+    }
+
+    /**
+     * @brief Content types worth compressing: text, JSON, JavaScript, XML and SVG.
+     *
+     * Images, archives and other already compressed formats are left alone, as compressing
+     * them costs CPU for no gain.
+     */
+    [[nodiscard]] inline bool compressible(std::string_view content_type) noexcept {
+        content_type = content_type.substr(0, content_type.find(';'));
+        while (!content_type.empty() && content_type.back() == ' ') content_type.remove_suffix(1);
+        if (content_type.starts_with("text/")) return true;
+        if (content_type.ends_with("+json") || content_type.ends_with("+xml")) return true;
+        return content_type == "application/json" || content_type == "application/javascript" ||
+               content_type == "application/xml" || content_type == "image/svg+xml";
+    }
+
+    /// @brief Best coding the client accepts, preferring brotli, then gzip, then deflate.
+    [[nodiscard]] inline coding negotiate(const Request &req) {
+        if (req.find(http::field::accept_encoding) == req.end()) return coding::identity;
+#if BULGOGI_BROTLI
+        if (accepts_encoding(req, "br")) return coding::br;
+#endif
+        if (accepts_encoding(req, "gzip")) return coding::gzip;
+        if (accepts_encoding(req, "deflate")) return coding::deflate;
+        return coding::identity;
+    }
+
+    namespace detail {
+
+        /**
+         * @brief A zlib deflate stream kept for the lifetime of a thread.
+         *
+         * `deflateReset` keeps the window and hash tables allocated by `deflateInit2`, so once a
+         * thread has compressed one response, later ones do not touch the heap inside zlib.
+         */
+        class zlib_context {
+            z_stream zs_{};
+            bool ok_ = false;
+
+        public:
+            /// @param window_bits 15 + 16 for a gzip wrapper, 15 for zlib (HTTP `deflate`).
+            zlib_context(int window_bits, int level) {
+                ok_ = deflateInit2(&zs_, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+            }
+
+            ~zlib_context() {
+                if (ok_) deflateEnd(&zs_);
+            }
+
+            zlib_context(const zlib_context &) = delete;
+            zlib_context &operator=(const zlib_context &) = delete;
+
+            /// @brief Compress @p in into @p out (replacing its contents); false on failure.
+            bool compress(std::string_view in, std::string &out) {
+                if (!ok_ || deflateReset(&zs_) != Z_OK) return false;
+                out.resize(deflateBound(&zs_, static_cast<uLong>(in.size())));
+                zs_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+                zs_.avail_in = static_cast<uInt>(in.size());
+                zs_.next_out = reinterpret_cast<Bytef *>(out.data());
+                zs_.avail_out = static_cast<uInt>(out.size());
+                if (deflate(&zs_, Z_FINISH) != Z_STREAM_END) return false;
+                out.resize(zs_.total_out);
+                return true;
+            }
+        };
+
+        inline zlib_context &gzip_context() {
+            thread_local zlib_context context(15 + 16, COMPRESSION_LEVEL);
+            return context;
+        }
+
+        inline zlib_context &deflate_context() {
+            thread_local zlib_context context(15, COMPRESSION_LEVEL);
+            return context;
+        }
+
+#if BULGOGI_BROTLI
+        /**
+         * @brief Per-thread free lists for the brotli encoder's allocations.
+         *
+         * A brotli encoder cannot be reset, so one is created per response. Its allocations are
+         * routed here and rounded up to powers of two; freed blocks are kept per size class and
+         * handed to the next encoder on the same thread instead of going back to the heap.
+         */
+        class brotli_pool {
+            static constexpr std::size_t header = alignof(std::max_align_t);
+            static constexpr std::size_t classes = 40;
+            static constexpr std::size_t kept_per_class = 8;
+
+            std::array<std::vector<void *>, classes> free_{};
+
+        public:
+            brotli_pool() = default;
+            brotli_pool(const brotli_pool &) = delete;
+            brotli_pool &operator=(const brotli_pool &) = delete;
+
+            ~brotli_pool() {
+                for (auto &list: free_) {
+                    for (void *block: list) std::free(block);
+                }
+            }
+
+            void *allocate(std::size_t n) {
+                std::size_t cls = 4;
+                while ((std::size_t(1) << cls) < n + header) ++cls;
+                if (cls >= classes) return nullptr;
+
+                void *block;
+                if (!free_[cls].empty()) {
+                    block = free_[cls].back();
+                    free_[cls].pop_back();
+                } else {
+                    block = std::malloc(std::size_t(1) << cls);
+                    if (!block) return nullptr;
+                    *static_cast<std::size_t *>(block) = cls;
+                }
+                return static_cast<char *>(block) + header;
+            }
+
+            void deallocate(void *p) {
+                if (!p) return;
+                void *block = static_cast<char *>(p) - header;
+                const std::size_t cls = *static_cast<std::size_t *>(block);
+                if (free_[cls].size() < kept_per_class) free_[cls].push_back(block);
+                else std::free(block);
+            }
+
+            static void *alloc_func(void *opaque, std::size_t n) {
+                return static_cast<brotli_pool *>(opaque)->allocate(n);
+            }
+
+            static void free_func(void *opaque, void *p) {
+                static_cast<brotli_pool *>(opaque)->deallocate(p);
+            }
+        };
+
+        inline brotli_pool &thread_brotli_pool() {
+            thread_local brotli_pool pool;
+            return pool;
+        }
+
+        /// @brief Brotli window (1 MiB): bounds encoder memory, and responses rarely benefit from more.
+        inline constexpr int brotli_window_bits = 20;
+
+        /// @brief Compress @p in with brotli at @p quality into @p out; false on failure.
+        inline bool brotli_compress(std::string_view in, std::string &out, int quality) {
+            auto &pool = thread_brotli_pool();
+            BrotliEncoderState *state = BrotliEncoderCreateInstance(&brotli_pool::alloc_func,
+                                                                    &brotli_pool::free_func, &pool);
+            if (!state) return false;
+            BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, static_cast<std::uint32_t>(quality));
+            BrotliEncoderSetParameter(state, BROTLI_PARAM_LGWIN, brotli_window_bits);
+
+            out.resize(BrotliEncoderMaxCompressedSize(in.size()));
+            std::size_t avail_in = in.size();
+            auto next_in = reinterpret_cast<const std::uint8_t *>(in.data());
+            std::size_t avail_out = out.size();
+            auto next_out = reinterpret_cast<std::uint8_t *>(out.data());
+
+            bool ok = true;
+            while (ok && !BrotliEncoderIsFinished(state)) {
+                ok = BrotliEncoderCompressStream(state, BROTLI_OPERATION_FINISH, &avail_in, &next_in,
+                                                 &avail_out, &next_out, nullptr);
+                if (avail_out == 0 && !BrotliEncoderIsFinished(state)) ok = false;
+            }
+            BrotliEncoderDestroyInstance(state);
+            if (!ok) return false;
+            out.resize(out.size() - avail_out);
+            return true;
+        }
+#endif
+
+        /**
+         * @brief Per-thread output buffer; it trades places with the response body on success,
+         *        so it always holds the capacity of the last uncompressed body.
+         */
+        inline std::string &scratch() {
+            thread_local std::string buffer;
+            return buffer;
+        }
+
+        inline void add_vary(Response &res) {
+            const auto it = res.find(http::field::vary);
+            if (it == res.end()) return res.set(http::field::vary, "Accept-Encoding");
+            const std::string_view vary = it->value();
+            if (vary.find('*') != std::string_view::npos) return;
+            for (std::size_t i = 0; i + 15 <= vary.size(); ++i) {
+                if (beast::iequals(vary.substr(i, 15), "Accept-Encoding")) return;
+            }
+            res.set(http::field::vary, std::string(vary) + ", Accept-Encoding");
+        }
+    }
+
+    /**
+     * @brief Compress @p in with @p c at the configured level into @p out.
+     * @return false if the coding is unavailable or the compressor failed.
+     */
+    inline bool compress(coding c, std::string_view in, std::string &out) {
+        switch (c) {
+            case coding::gzip: return detail::gzip_context().compress(in, out);
+            case coding::deflate: return detail::deflate_context().compress(in, out);
+#if BULGOGI_BROTLI
+            case coding::br: return detail::brotli_compress(in, out, BROTLI_QUALITY);
+#endif
+            default: return false;
+        }
+    }
+
+    /**
+     * @brief Compress a finished response body in place if the client and the response allow it.
+     *
+     * Called by the server after the handler when built with `ENABLE_COMPRESSION`. The body is
+     * left alone when:
+     * - it is shorter than `COMPRESSION_MIN_SIZE` bytes;
+     * - the status is informational, `204`, `206` or `304`;
+     * - the handler already set `Content-Encoding` (set it to `identity` to opt out);
+     * - the `Content-Type` is not `compressible()`;
+     * - compressing does not make it smaller.
+     *
+     * Compressible responses always get `Vary: Accept-Encoding`. A strong `ETag` set by the
+     * handler is turned into a weak one, since the bytes no longer match the original.
+     *
+     * A `HEAD` whose handler built the full body gets the same headers as the `GET` (coding and
+     * compressed `Content-Length`), and the body is dropped.
+     */
+    inline void compress_response(const Request &req, Response &res) {
+        auto &body = res.body();
+        if (body.empty() || body.size() < COMPRESSION_MIN_SIZE) return;
+        const unsigned status = res.result_int();
+        if (status < 200 || status == 204 || status == 206 || status == 304) return;
+        if (res.find(http::field::content_encoding) != res.end()) return;
+        if (!compressible(res[http::field::content_type])) return;
+
+        detail::add_vary(res);
+        const coding c = negotiate(req);
+        if (c == coding::identity) return;
+
+        auto &out = detail::scratch();
+        if (!compress(c, body, out) || out.size() >= body.size()) return;
+        body.swap(out);
+
+        res.set(http::field::content_encoding, name_of(c));
+        if (const auto etag = res.find(http::field::etag); etag != res.end() && !etag->value().starts_with("W/")) {
+            res.set(http::field::etag, "W/" + std::string(etag->value()));
+        }
+        res.content_length(body.size());
+        if (req.method() == http::verb::head) body.clear();  // the length above still describes the GET
+    }
+}
@@ -0,0 +1,161 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "bulgogi.hpp"
+#include "canned_response.hpp"
+
+
+namespace bulgogi {
+
+    /**
+     * @brief CORS settings of a route, rendered once instead of on every request.
+     *
+     * `apply_cors` and `check_method(req, {verbs...}, res, origin)` rebuild the method list and
+     * copy every header value per call. A policy renders the header values and the `OPTIONS`
+     * answer when it is constructed; afterwards the method check is a bit test and applying it
+     * only copies pre-rendered views into the response.
+     *
+     * Declare one per route with static storage and pass it to `check_method`:
+     * @code{.cpp}
+     * inline const bulgogi::cors_policy user_cors{{bulgogi::http::verb::get, bulgogi::http::verb::post},
+     *                                             "https://app.example.com", true};
+     * REGISTER_CORS(user_cors, "api/user/info");
+     *
+     * REGISTER_VIEW(api, user, info) {
+     *     if (!bulgogi::check_method(req, user_cors, res)) return;
+     *     ...
+     * }
+     * @endcode
+     *
+     * With `REGISTER_CORS(...)` the server answers preflight requests for the route from the
+     * pre-rendered response without calling the handler.
+     *
+     * An empty origin or `"null"` (or building with `NO_CORS`) disables CORS for the route, with
+     * the same behaviour as `check_method`.
+     */
+    class cors_policy {
+        std::uint64_t methods_ = 0;
+        std::string origin_;
+        std::string allow_methods_;
+        std::string expected_;
+        bool credentials_ = false;
+        bool enabled_ = false;
+        canned_response preflight_;
+
+        static constexpr std::uint64_t bit(http::verb v) noexcept {
+            return std::uint64_t(1) << static_cast<unsigned>(v);
+        }
+
+    public:
+        /**
+         * @param methods Allowed methods (`OPTIONS` is implied for preflight).
+         * @param origin Allowed origin, `cors::all` for any.
+         * @param credentials Send `Access-Control-Allow-Credentials: true`.
+         * @throws std::invalid_argument if @p credentials is combined with a wildcard origin.
+         */
+        cors_policy(std::initializer_list<http::verb> methods, std::string_view origin = cors::all,
+                    bool credentials = false)
+                : origin_(origin),
+                  allow_methods_(detail::join_methods(methods, true)),
+                  expected_(detail::join_methods(methods)),
+                  credentials_(credentials) {
+            static_assert(static_cast<unsigned>(http::verb::unlink) < 64, "http::verb does not fit the mask");
+            for (const http::verb v: methods) methods_ |= bit(v);
+#ifndef NO_CORS
+            enabled_ = !origin_.empty() && origin_ != cors::none;
+#endif
+            if (enabled_ && credentials_ && origin_ == cors::all) {
+                throw std::invalid_argument("cors_policy: credentials=true requires a specific origin, not '*'");
+            }
+
+            Response preflight{http::status::no_content, 11};
+            apply(preflight);
+            preflight_ = canned_response(preflight);
+        }
+
+        [[nodiscard]] bool allows(http::verb v) const noexcept { return (methods_ & bit(v)) != 0; }
+
+        [[nodiscard]] bool enabled() const noexcept { return enabled_; }
+
+        [[nodiscard]] std::string_view origin() const noexcept { return origin_; }
+
+        /// @brief Allowed methods without `OPTIONS`, e.g. `GET, POST`.
+        [[nodiscard]] std::string_view expected() const noexcept { return expected_; }
+
+        /// @brief True if a request from @p request_origin (empty when absent) may be answered.
+        [[nodiscard]] bool accepts_origin(std::string_view request_origin) const noexcept {
+            return request_origin.empty() || origin_ == cors::all || origin_ == request_origin;
+        }
+
+        /// @brief Set the pre-rendered CORS headers on @p res; no-op when disabled.
+        void apply(Response &res) const {
+            if (!enabled_) return;
+            res.set(http::field::access_control_allow_origin, origin_);
+            res.set(http::field::access_control_allow_methods, allow_methods_);
+            res.set(http::field::access_control_allow_headers, "Content-Type, Authorization");
+            res.set(http::field::access_control_max_age, STR(CORS_MAX_AGE));
+            if (credentials_) res.set(http::field::access_control_allow_credentials, "true");
+        }
+
+        /// @brief The complete `204` preflight answer, valid when `accepts_origin()` holds.
+        [[nodiscard]] const canned_response &preflight() const noexcept { return preflight_; }
+    };
+
+    /**
+     * @brief `check_method` with a pre-rendered policy; same responses as the list overload.
+     * @return `true` if the handler should proceed.
+     */
+    inline bool check_method(const Request &req, const cors_policy &policy, Response &res) {
+        const auto origin_hdr = req.find(http::field::origin);
+        const auto req_method = req.method();
+
+        if (!policy.enabled()) {
+            if (origin_hdr != req.end()) {
+                set_json(res, {
+                        {"error", "CORS disabled"},
+                        {"detail", "This endpoint does not allow cross-origin access"}
+                }, 403);
+                return false;
+            }
+            if (req_method == http::verb::options) {
+                set_json(res, {
+                        {"error", "Preflight denied"},
+                        {"detail", "CORS preflight not allowed on this route"}
+                }, 405);
+                return false;
+            }
+        } else if (origin_hdr != req.end() && !policy.accepts_origin(origin_hdr->value())) {
+            set_json(res, {
+                    {"error",   "CORS origin mismatch"},
+                    {"allowed", std::string(policy.origin())},
+                    {"got",     std::string(origin_hdr->value())}
+            }, 403);
+            return false;
+        }
+
+        if (req_method == http::verb::options) {
+            policy.apply(res);
+            return false;
+        }
+
+        if (!policy.allows(req_method)) {
+            set_json(res, {
+                    {"error",    "Method Not Allowed"},
+                    {"expected", policy.expected()},
+                    {"got",      http::to_string(req_method)}
+            }, 405);
+            policy.apply(res);
+            return false;
+        }
+
+        policy.apply(res);
+        return true;
+    }
+}
@@ -0,0 +1,382 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <nghttp2/nghttp2.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "marcos.hpp"
+#include "bulgogi.hpp"
+#include "canned_response.hpp"
+#include "logger.hpp"
+
+
+/**
+ * @brief HTTP/2 transport for builds with `ENABLE_HTTP2`, on top of libnghttp2.
+ *
+ * nghttp2 does the framing, HPACK header compression, stream state and flow control; it never
+ * touches the socket. `connection` is fed the bytes read from the client (`receive`) and hands
+ * back the bytes to write (`pending`), so the session keeps owning its stream, strand and
+ * timeouts exactly as for HTTP/1.
+ *
+ * Each request stream surfaces as a `stream` holding a regular `Request` (version 20, `:path`
+ * as target, `:authority` as `Host`), so it is routed to the same handlers. Responses go back as
+ * a string body, a canned response or a `set_stream` producer, which nghttp2 pulls one DATA frame
+ * at a time as the peer's flow-control window allows.
+ *
+ * Inbound flow control: every stream may have `HTTP2_WINDOW_SIZE` bytes of request body in
+ * flight, the connection eight times that. Consumed bytes are acknowledged automatically, since
+ * bodies are appended to the request (bounded by the route's body limit) or handed straight to
+ * a `receive_body` consumer. At most `HTTP2_MAX_STREAMS` streams are open at once.
+ */
+namespace bulgogi::http2 {
+
+    /// @brief What a prior-knowledge (h2c) client sends before anything else.
+    inline constexpr std::string_view client_preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+    /// @brief Largest request header block accepted (HPACK accounting: name + value + 32 per field).
+    inline constexpr std::size_t header_list_limit = 16384;
+
+    enum class preface { mismatch, partial, complete };
+
+    /// @brief How far @p data agrees with `client_preface`.
+    inline preface match_preface(std::string_view data) noexcept {
+        const auto n = std::min(data.size(), client_preface.size());
+        if (data.substr(0, n) != client_preface.substr(0, n)) return preface::mismatch;
+        return n == client_preface.size() ? preface::complete : preface::partial;
+    }
+
+    namespace detail {
+        inline std::atomic<std::uint64_t> connections{0};
+        inline std::atomic<std::uint64_t> streams{0};
+    }
+
+    /// @brief HTTP/2 connections started (prior knowledge or ALPN).
+    [[maybe_unused]] inline std::uint64_t connections() { return detail::connections.load(std::memory_order_relaxed); }
+
+    /// @brief Request streams received over HTTP/2.
+    [[maybe_unused]] inline std::uint64_t streams() { return detail::streams.load(std::memory_order_relaxed); }
+
+    /// @brief One request and its response on a connection.
+    struct stream {
+        std::int32_t id = 0;
+        Request req{http::verb::unknown, "", 20};
+        bool complete = false;     ///< The whole request, body included, has arrived
+        bool answered = false;     ///< A response was submitted; further request data is dropped
+
+        // Set by the session when the headers are in
+        std::uint64_t body_limit = MAX_BODY_SIZE;
+        std::uint32_t metric = 0;
+        std::optional<bulgogi::detail::pending_body> upload;  ///< `REGISTER_STREAMING_BODY` consumer
+
+        // Access log
+        std::chrono::steady_clock::time_point started;
+        unsigned status = 0;
+        std::uint64_t sent = 0;  ///< Body bytes handed to nghttp2
+
+    private:
+        friend class connection;
+
+        std::size_t header_bytes_ = 0;
+        std::string body_;  // string or canned body being sent
+        std::size_t body_offset_ = 0;
+        std::optional<bulgogi::detail::pending_stream> source_;
+    };
+
+    /**
+     * @brief Server side of one HTTP/2 connection.
+     *
+     * Not thread-safe; all calls, and so all callbacks, happen on the owning session's strand.
+     * Callbacks may submit responses from inside `receive`.
+     */
+    class connection {
+    public:
+        struct handlers {
+            std::function<void(stream &)> on_headers;                    ///< Request headers complete
+            std::function<void(stream &, std::string_view)> on_data;     ///< A piece of the request body
+            std::function<void(stream &)> on_request;                    ///< Request complete (`stream::complete`)
+            std::function<void(stream &)> on_close;                      ///< Stream finished or reset
+        };
+
+        /**
+         * @brief Start the server session and queue its SETTINGS.
+         * @throws std::runtime_error if nghttp2 cannot allocate the session.
+         */
+        explicit connection(handlers h) : handlers_(std::move(h)) {
+            nghttp2_session_callbacks *callbacks = nullptr;
+            if (nghttp2_session_callbacks_new(&callbacks) != 0) throw std::runtime_error("nghttp2: out of memory");
+            nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, &connection::on_begin_headers);
+            nghttp2_session_callbacks_set_on_header_callback(callbacks, &connection::on_header);
+            nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, &connection::on_frame_recv);
+            nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, &connection::on_data_chunk);
+            nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, &connection::on_stream_close);
+
+            const int rv = nghttp2_session_server_new(&session_, callbacks, this);
+            nghttp2_session_callbacks_del(callbacks);
+            if (rv != 0) throw std::runtime_error(std::string("nghttp2: ") + nghttp2_strerror(rv));
+
+            const nghttp2_settings_entry settings[] = {
+                    {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, HTTP2_MAX_STREAMS},
+                    {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, HTTP2_WINDOW_SIZE},
+                    {NGHTTP2_SETTINGS_MAX_HEADER_LIST_SIZE, header_list_limit},
+            };
+            nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, settings, std::size(settings));
+            constexpr auto max_window = static_cast<std::uint64_t>(std::numeric_limits<std::int32_t>::max());
+            nghttp2_session_set_local_window_size(
+                    session_, NGHTTP2_FLAG_NONE, 0,
+                    static_cast<std::int32_t>(std::min<std::uint64_t>(std::uint64_t{HTTP2_WINDOW_SIZE} * 8, max_window)));
+            detail::connections.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ~connection() { nghttp2_session_del(session_); }
+
+        connection(const connection &) = delete;
+        connection &operator=(const connection &) = delete;
+
+        /**
+         * @brief Process bytes read from the client; handlers run from in here.
+         * @return False on a connection error; a GOAWAY is then queued and nothing more is read.
+         */
+        bool receive(std::string_view data) {
+            const auto rv = nghttp2_session_mem_recv(session_, reinterpret_cast<const std::uint8_t *>(data.data()),
+                                                     data.size());
+            return rv >= 0;
+        }
+
+        /**
+         * @brief Serialise queued frames, up to about @p max bytes.
+         * @return Bytes to write, valid until the next call; empty when nothing is queued or the
+         *         peer's windows are exhausted.
+         */
+        std::string_view pending(std::size_t max = STREAM_BUFFER_SIZE) {
+            out_.clear();
+            while (out_.size() < max) {
+                const std::uint8_t *data = nullptr;
+                const auto n = nghttp2_session_mem_send(session_, &data);
+                if (n <= 0) break;
+                out_.append(reinterpret_cast<const char *>(data), static_cast<std::size_t>(n));
+            }
+            return out_;
+        }
+
+        /// @brief False once the connection is finished (GOAWAY exchanged, fatal error, no streams left).
+        [[nodiscard]] bool alive() const {
+            return nghttp2_session_want_read(session_) != 0 || nghttp2_session_want_write(session_) != 0;
+        }
+
+        /// @brief Streams with a request or response still in progress.
+        [[nodiscard]] std::size_t open_streams() const noexcept { return streams_.size(); }
+
+        /// @brief Refuse new streams (GOAWAY) and let the open ones finish.
+        void shutdown() {
+            if (shutting_down_) return;
+            shutting_down_ = true;
+            nghttp2_submit_goaway(session_, NGHTTP2_FLAG_NONE, nghttp2_session_get_last_proc_stream_id(session_),
+                                  NGHTTP2_NO_ERROR, nullptr, 0);
+        }
+
+        /// @brief Send an interim response such as `100 Continue`.
+        void informational(stream &s, unsigned status) {
+            const std::string code = std::to_string(status);
+            const nghttp2_nv nv[] = {make_nv(":status", code)};
+            nghttp2_submit_headers(session_, NGHTTP2_FLAG_NONE, s.id, nullptr, nv, 1, nullptr);
+        }
+
+        /// @brief Answer with @p res; only the headers for `HEAD`.
+        void respond(stream &s, const Response &res) {
+            s.status = res.result_int();
+            if (s.req.method() != http::verb::head) s.body_ = res.body();
+            submit(s, res.base(), s.req.method() == http::verb::head || s.body_.empty() ? nullptr : &s);
+        }
+
+        /// @brief Answer with a pre-rendered response; a non-empty @p age (response cache hits) is sent as `age`.
+        void respond(stream &s, const canned_response &canned, std::string_view age = {}) {
+            s.status = canned.status();
+            if (s.req.method() != http::verb::head) s.body_ = canned.body();
+            const std::string code = std::to_string(s.status);
+            std::vector<nghttp2_nv> nv;
+            nv.reserve(canned.fields().size() + 2);
+            nv.push_back(make_nv(":status", code));
+            for (const auto &[name, value]: canned.fields()) nv.push_back(make_nv(name, value));
+            if (!age.empty()) nv.push_back(make_nv("age", age));
+            submit(s, nv, s.body_.empty() ? nullptr : &s);
+        }
+
+        /// @brief Answer with @p header and a body pulled from @p source as the window allows.
+        void respond(stream &s, const http::response_header<> &header, bulgogi::detail::pending_stream &&source) {
+            s.status = header.result_int();
+            const bool head = s.req.method() == http::verb::head;
+            if (!head) s.source_ = std::move(source);
+            submit(s, header, head ? nullptr : &s);
+        }
+
+    private:
+        nghttp2_session *session_ = nullptr;
+        handlers handlers_;
+        std::unordered_map<std::int32_t, std::unique_ptr<stream>> streams_;
+        std::string out_;
+        bool shutting_down_ = false;
+
+        static nghttp2_nv make_nv(std::string_view name, std::string_view value) {
+            return {reinterpret_cast<std::uint8_t *>(const_cast<char *>(name.data())),
+                    reinterpret_cast<std::uint8_t *>(const_cast<char *>(value.data())),
+                    name.size(), value.size(), NGHTTP2_NV_FLAG_NONE};
+        }
+
+        /// @brief Headers that only mean something on an HTTP/1 connection.
+        static bool connection_specific(http::field f) noexcept {
+            return f == http::field::connection || f == http::field::keep_alive ||
+                   f == http::field::proxy_connection || f == http::field::transfer_encoding ||
+                   f == http::field::upgrade;
+        }
+
+        void submit(stream &s, const http::response_header<> &header, stream *body) {
+            const std::string code = std::to_string(header.result_int());
+            std::vector<std::string> names;
+            names.reserve(std::distance(header.begin(), header.end()));
+            std::vector<nghttp2_nv> nv;
+            nv.reserve(names.capacity() + 1);
+            nv.push_back(make_nv(":status", code));
+            for (const auto &field: header) {
+                if (connection_specific(field.name())) continue;
+                auto &name = names.emplace_back(field.name_string());
+                for (auto &c: name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                nv.push_back(make_nv(name, field.value()));
+            }
+            submit(s, nv, body);  // nghttp2 copies the header block
+        }
+
+        void submit(stream &s, const std::vector<nghttp2_nv> &nv, stream *body) {
+            s.answered = true;
+            nghttp2_data_provider provider{};
+            provider.source.ptr = body;
+            provider.read_callback = &connection::read_body;
+            nghttp2_submit_response(session_, s.id, nv.data(), nv.size(), body ? &provider : nullptr);
+        }
+
+        static stream *find(nghttp2_session *session, std::int32_t id) {
+            return static_cast<stream *>(nghttp2_session_get_stream_user_data(session, id));
+        }
+
+        static int on_begin_headers(nghttp2_session *session, const nghttp2_frame *frame, void *user) {
+            auto &self = *static_cast<connection *>(user);
+            if (frame->hd.type != NGHTTP2_HEADERS || frame->headers.cat != NGHTTP2_HCAT_REQUEST) return 0;
+            auto s = std::make_unique<stream>();
+            s->id = frame->hd.stream_id;
+            nghttp2_session_set_stream_user_data(session, s->id, s.get());
+            self.streams_.emplace(s->id, std::move(s));
+            detail::streams.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+
+        static int on_header(nghttp2_session *session, const nghttp2_frame *frame, const std::uint8_t *name_data,
+                             std::size_t name_length, const std::uint8_t *value_data, std::size_t value_length,
+                             std::uint8_t, void *) {
+            stream *s = find(session, frame->hd.stream_id);
+            if (!s || frame->headers.cat != NGHTTP2_HCAT_REQUEST) return 0;  // trailers are dropped
+
+            s->header_bytes_ += name_length + value_length + 32;
+            if (s->header_bytes_ > header_list_limit) return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+
+            const std::string_view name(reinterpret_cast<const char *>(name_data), name_length);
+            const std::string_view value(reinterpret_cast<const char *>(value_data), value_length);
+            auto &req = s->req;
+            if (name == ":method") {
+                req.method_string(value);
+            } else if (name == ":path") {
+                req.target(value);
+            } else if (name == ":authority") {
+                if (req.find(http::field::host) == req.end()) req.set(http::field::host, value);
+            } else if (name.front() == ':') {
+                // :scheme, :protocol
+            } else if (name == "cookie" && req.find(http::field::cookie) != req.end()) {
+                // Split into several fields for better compression; one header again for handlers
+                req.set(http::field::cookie, std::string(req[http::field::cookie]) + "; " + std::string(value));
+            } else {
+                req.insert(name, value);
+            }
+            return 0;
+        }
+
+        static int on_frame_recv(nghttp2_session *session, const nghttp2_frame *frame, void *user) {
+            auto &self = *static_cast<connection *>(user);
+            if (frame->hd.type != NGHTTP2_HEADERS && frame->hd.type != NGHTTP2_DATA) return 0;
+            stream *s = find(session, frame->hd.stream_id);
+            if (!s) return 0;
+
+            const bool end = (frame->hd.flags & NGHTTP2_FLAG_END_STREAM) != 0;
+            if (end) s->complete = true;
+            if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
+                self.handlers_.on_headers(*s);
+            }
+            if (end) self.handlers_.on_request(*s);
+            return 0;
+        }
+
+        static int on_data_chunk(nghttp2_session *session, std::uint8_t, std::int32_t id, const std::uint8_t *data,
+                                 std::size_t length, void *user) {
+            auto &self = *static_cast<connection *>(user);
+            stream *s = find(session, id);
+            if (s && !s->answered) {
+                self.handlers_.on_data(*s, std::string_view(reinterpret_cast<const char *>(data), length));
+            }
+            return 0;
+        }
+
+        static int on_stream_close(nghttp2_session *, std::int32_t id, std::uint32_t, void *user) {
+            auto &self = *static_cast<connection *>(user);
+            const auto it = self.streams_.find(id);
+            if (it == self.streams_.end()) return 0;
+            self.handlers_.on_close(*it->second);
+            self.streams_.erase(it);
+            return 0;
+        }
+
+        /// @brief Fill one DATA frame from the stream's body or producer.
+        static ssize_t read_body(nghttp2_session *, std::int32_t, std::uint8_t *buffer, std::size_t length,
+                                 std::uint32_t *flags, nghttp2_data_source *source, void *) {
+            auto &s = *static_cast<stream *>(source->ptr);
+            auto *out = reinterpret_cast<char *>(buffer);
+
+            if (!s.source_) {
+                const auto n = std::min(length, s.body_.size() - s.body_offset_);
+                std::memcpy(out, s.body_.data() + s.body_offset_, n);
+                s.body_offset_ += n;
+                s.sent += n;
+                if (s.body_offset_ == s.body_.size()) *flags |= NGHTTP2_DATA_FLAG_EOF;
+                return static_cast<ssize_t>(n);
+            }
+
+            const auto &expected = s.source_->content_length;
+            if (expected) length = static_cast<std::size_t>(std::min<std::uint64_t>(length, *expected - s.sent));
+            std::size_t n = 0;
+            try {
+                if (length > 0) n = s.source_->producer(out, length);
+            } catch (const std::exception &e) {
+                bulgogi::log::error(std::string("Stream producer error: ") + e.what());
+                return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;  // resets the stream
+            }
+            if (n > length || (expected && n == 0 && s.sent != *expected)) {
+                bulgogi::log::error("Stream producer error: body does not match Content-Length");
+                return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+            }
+            s.sent += n;
+            if (n == 0 || (expected && s.sent == *expected)) *flags |= NGHTTP2_DATA_FLAG_EOF;
+            return static_cast<ssize_t>(n);
+        }
+    };
+}
@@ -0,0 +1,140 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <boost/json.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include "marcos.hpp"
+
+
+namespace bulgogi {
+
+    namespace detail {
+
+        /// @brief Heap upstream for the JSON arena that remembers how much it had to hand out.
+        class counting_resource final : public boost::json::memory_resource {
+        public:
+            std::size_t allocated = 0;
+
+        private:
+            void *do_allocate(std::size_t n, std::size_t align) override {
+                allocated += n;
+                return ::operator new(n, std::align_val_t(align));
+            }
+
+            void do_deallocate(void *p, std::size_t, std::size_t align) override {
+                ::operator delete(p, std::align_val_t(align));
+            }
+
+            [[nodiscard]] bool do_is_equal(const boost::json::memory_resource &other) const noexcept override {
+                return this == &other;
+            }
+        };
+
+        /**
+         * @brief Per-thread parse arena: one reusable buffer plus a monotonic resource over it.
+         *
+         * When a document spills past the buffer, the overflow is counted and the buffer grows to
+         * cover it (up to `JSON_ARENA_MAX` bytes) before the next parse, so a thread that keeps
+         * receiving bodies of a given size settles on a buffer that fits them.
+         */
+        struct json_arena {
+            std::unique_ptr<unsigned char[]> buffer;
+            std::size_t size = 0;
+            counting_resource upstream;
+            std::unique_ptr<boost::json::monotonic_resource> resource;
+            bool in_use = false;
+
+            boost::json::monotonic_resource &acquire() {
+                const std::size_t wanted = std::min<std::size_t>(
+                        std::max<std::size_t>(size + upstream.allocated, JSON_ARENA_SIZE), JSON_ARENA_MAX);
+                if (!resource || wanted > size) {
+                    resource.reset();
+                    buffer = std::make_unique<unsigned char[]>(wanted);
+                    size = wanted;
+                    resource = std::make_unique<boost::json::monotonic_resource>(buffer.get(), size, &upstream);
+                }
+                upstream.allocated = 0;
+                in_use = true;
+                return *resource;
+            }
+
+            void release() noexcept {
+                resource->release();
+                in_use = false;
+            }
+        };
+
+        inline json_arena &thread_json_arena() {
+            thread_local json_arena arena;
+            return arena;
+        }
+    }
+
+    /**
+     * @brief A parsed JSON body allocated from the calling thread's reusable arena.
+     *
+     * Every node of the document is carved out of a per-thread buffer through a
+     * `boost::json::monotonic_resource`, so parsing does not touch the global heap once the
+     * buffer has grown to fit typical bodies, and nothing is freed node by node: the whole arena
+     * is reset when the document is destroyed.
+     *
+     * The document is meant to live for one request on one thread:
+     * - keep it as a local in the handler and do not move it to another thread;
+     * - values obtained from it (references, `string_view`s) die with it — copy them into owned
+     *   values (e.g. `boost::json::value copy(doc.value(), {})`) if they must outlive the request;
+     * - if a second document is created while one is alive on the same thread, it falls back to
+     *   a private arena, so nesting is safe but does not reuse the thread buffer.
+     */
+    class json_document {
+        detail::json_arena *arena_ = nullptr;
+        std::unique_ptr<boost::json::monotonic_resource> own_;
+        boost::json::value value_;
+
+        /// @brief Parse with the arena's storage; the value is move-constructed so it keeps it.
+        static boost::json::value parse(std::string_view text, detail::json_arena *arena,
+                                        std::unique_ptr<boost::json::monotonic_resource> &own) {
+            if (!arena) {
+                own = std::make_unique<boost::json::monotonic_resource>();
+                return boost::json::parse(text, own.get());
+            }
+            try {
+                return boost::json::parse(text, &arena->acquire());
+            } catch (...) {
+                arena->release();
+                throw;
+            }
+        }
+
+    public:
+        /**
+         * @brief Parse @p text into the thread arena.
+         * @throws boost::system::system_error on invalid JSON.
+         */
+        explicit json_document(std::string_view text)
+                : arena_(detail::thread_json_arena().in_use ? nullptr : &detail::thread_json_arena()),
+                  value_(parse(text, arena_, own_)) {}
+
+        ~json_document() {
+            value_ = nullptr;  // drop nodes while their storage is still valid
+            if (arena_) arena_->release();
+        }
+
+        json_document(const json_document &) = delete;
+        json_document &operator=(const json_document &) = delete;
+
+        /// @brief The parsed root value.
+        [[nodiscard]] const boost::json::value &value() const noexcept { return value_; }
+
+        /**
+         * @brief The root as an object.
+         * @throws boost::system::system_error if the root is not an object.
+         */
+        [[nodiscard]] const boost::json::object &object() const { return value_.as_object(); }
+    };
+}
@@ -0,0 +1,220 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+namespace bulgogi {
+
+    /**
+     * @brief Forward-only JSON writer that appends straight into a string (usually `res.body()`).
+     *
+     * `set_json(res, value)` first builds a `boost::json::value` tree (one allocation per node)
+     * and then serializes it into a fresh string. For large responses such as list endpoints,
+     * write tokens directly instead:
+     *
+     * @code{.cpp}
+     * bulgogi::json_writer w(res.body(), rows.size() * 64);
+     * w.begin_object();
+     * w.key("rows");
+     * w.begin_array();
+     * for (const auto &row: rows) {
+     *     w.begin_object();
+     *     w.member("id", row.id);
+     *     w.member("name", row.name);
+     *     w.end_object();
+     * }
+     * w.end_array();
+     * w.end_object();
+     * bulgogi::set_json(res, w);
+     * @endcode
+     *
+     * Commas and the `:` after keys are inserted automatically. Strings are escaped in bulk runs,
+     * integers and floating point values go through `std::to_chars`, and non-finite doubles are
+     * written as `null`. Nesting is limited to `max_depth` levels; structural misuse (a value
+     * where a key is expected, unbalanced `end_*`) throws `std::logic_error`.
+     */
+    class json_writer {
+    public:
+        /// @brief Maximum nesting depth of objects and arrays.
+        static constexpr std::size_t max_depth = 64;
+
+        /**
+         * @brief Write into @p out, appending to whatever it already contains.
+         * @param out Target string, typically `res.body()`; must outlive the writer.
+         * @param reserve Bytes to reserve up front to avoid regrowth while writing.
+         */
+        explicit json_writer(std::string &out, std::size_t reserve = 0) : out_(&out) {
+            if (reserve) out_->reserve(out_->size() + reserve);
+        }
+
+        json_writer &begin_object() { return open('{', scope_object); }
+
+        json_writer &end_object() { return close('}', scope_object); }
+
+        json_writer &begin_array() { return open('[', scope_array); }
+
+        json_writer &end_array() { return close(']', scope_array); }
+
+        /// @brief Write an object key; the next call must write its value.
+        json_writer &key(std::string_view k) {
+            if (depth_ == 0 || scopes_[depth_ - 1] != scope_object || after_key_) {
+                throw std::logic_error("json_writer: key outside of an object");
+            }
+            separate();
+            write_string(k);
+            out_->push_back(':');
+            after_key_ = true;
+            return *this;
+        }
+
+        json_writer &null() {
+            before_value();
+            out_->append("null");
+            return *this;
+        }
+
+        json_writer &value(std::nullptr_t) { return null(); }
+
+        json_writer &value(bool b) {
+            before_value();
+            out_->append(b ? "true" : "false");
+            return *this;
+        }
+
+        json_writer &value(std::string_view s) {
+            before_value();
+            write_string(s);
+            return *this;
+        }
+
+        json_writer &value(const char *s) { return value(std::string_view(s)); }
+
+        json_writer &value(const std::string &s) { return value(std::string_view(s)); }
+
+        template<typename T>
+        requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+        json_writer &value(T v) {
+            before_value();
+            if constexpr (std::is_floating_point_v<T>) {
+                if (!std::isfinite(v)) {
+                    out_->append("null");
+                    return *this;
+                }
+            }
+            char buf[32];
+            const auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+            (void) ec;  // 32 bytes fit every integer and the shortest round-trip double
+            out_->append(buf, ptr);
+            return *this;
+        }
+
+        /// @brief Append an already serialized JSON fragment as a value, without validation.
+        json_writer &raw(std::string_view json) {
+            before_value();
+            out_->append(json);
+            return *this;
+        }
+
+        /// @brief Shorthand for `key(k).value(v)`.
+        template<typename T>
+        json_writer &member(std::string_view k, T &&v) {
+            key(k);
+            return value(std::forward<T>(v));
+        }
+
+        /// @brief True once every opened object/array has been closed and a value was written.
+        [[nodiscard]] bool complete() const noexcept {
+            return depth_ == 0 && wrote_root_;
+        }
+
+        /// @brief The string being written to.
+        [[nodiscard]] std::string &str() noexcept { return *out_; }
+
+    private:
+        static constexpr bool scope_object = true;
+        static constexpr bool scope_array = false;
+
+        json_writer &open(char c, bool scope) {
+            if (depth_ == max_depth) throw std::logic_error("json_writer: nesting too deep");
+            before_value();
+            out_->push_back(c);
+            scopes_[depth_] = scope;
+            has_items_[depth_] = false;
+            ++depth_;
+            return *this;
+        }
+
+        json_writer &close(char c, bool scope) {
+            if (depth_ == 0 || scopes_[depth_ - 1] != scope || after_key_) {
+                throw std::logic_error("json_writer: unbalanced end_object()/end_array()");
+            }
+            --depth_;
+            out_->push_back(c);
+            return *this;
+        }
+
+        /// @brief Emit the comma between siblings.
+        void separate() {
+            if (has_items_[depth_ - 1]) out_->push_back(',');
+            has_items_[depth_ - 1] = true;
+        }
+
+        void before_value() {
+            if (depth_ == 0) {
+                if (wrote_root_) throw std::logic_error("json_writer: more than one root value");
+                wrote_root_ = true;
+                return;
+            }
+            if (scopes_[depth_ - 1] == scope_object) {
+                if (!after_key_) throw std::logic_error("json_writer: object value without key");
+                after_key_ = false;
+                return;
+            }
+            separate();
+        }
+
+        void write_string(std::string_view s) {
+            static constexpr char hex[] = "0123456789abcdef";
+            out_->push_back('"');
+            std::size_t run = 0;
+            for (std::size_t i = 0; i < s.size(); ++i) {
+                const auto c = static_cast<unsigned char>(s[i]);
+                if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+                out_->append(s.data() + run, i - run);
+                run = i + 1;
+                switch (c) {
+                    case '"':  out_->append("\\\""); break;
+                    case '\\': out_->append("\\\\"); break;
+                    case '\n': out_->append("\\n"); break;
+                    case '\r': out_->append("\\r"); break;
+                    case '\t': out_->append("\\t"); break;
+                    case '\b': out_->append("\\b"); break;
+                    case '\f': out_->append("\\f"); break;
+                    default: {
+                        const char esc[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                        out_->append(esc, sizeof(esc));
+                    }
+                }
+            }
+            out_->append(s.data() + run, s.size() - run);
+            out_->push_back('"');
+        }
+
+        std::string *out_;
+        bool scopes_[max_depth]{};
+        bool has_items_[max_depth]{};
+        std::size_t depth_ = 0;
+        bool after_key_ = false;
+        bool wrote_root_ = false;
+    };
+}
@@ -0,0 +1,335 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "marcos.hpp"
+
+
+/**
+ * @brief Asynchronous access and error log.
+ *
+ * Session threads never touch a stream or a lock to log: a line is copied into a slot of a
+ * bounded multi-producer ring (`LOG_RING_SIZE` entries) and a background thread drains the ring,
+ * adds the timestamp and hands whole batches to `write(2)`. When the ring is full the line is
+ * dropped and counted in `dropped()` instead of slowing the server down.
+ *
+ * Lines use logfmt:
+ * @code
+ * ts=2025-01-31T12:00:00.123Z ip=127.0.0.1 method=GET route="/ping" status=200 bytes=143 latency_us=12
+ * ts=2025-01-31T12:00:01.456Z level=error msg="Session error: Connection reset by peer"
+ * @endcode
+ *
+ * Access lines go to `ACCESS_LOG` (a file path, `-` for stdout, empty to disable them); errors
+ * always go to stderr. Before `start()` and after `stop()` lines are written synchronously.
+ */
+namespace bulgogi::log {
+
+    enum class sink : std::uint8_t { access, error };
+
+    namespace detail {
+        static_assert(LOG_RING_SIZE >= 2 && (LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0,
+                      "LOG_RING_SIZE must be a power of two");
+
+        /// @brief One line; the text excludes the timestamp, which the writer adds.
+        struct alignas(64) entry {
+            static constexpr std::size_t capacity = 512 - 3 * sizeof(std::uint64_t);
+
+            std::atomic<std::size_t> sequence{0};
+            std::int64_t time_ns = 0;
+            std::uint16_t size = 0;
+            sink target = sink::error;
+            char text[capacity];
+        };
+
+        /// @brief Write all of @p data to @p fd, retrying partial writes and EINTR.
+        inline void write_all(int fd, std::string_view data) noexcept {
+            while (!data.empty()) {
+                const auto n = ::write(fd, data.data(), data.size());
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return;
+                data.remove_prefix(static_cast<std::size_t>(n));
+            }
+        }
+
+        /// @brief Append `ts=<UTC ISO-8601 with milliseconds> ` for @p time_ns.
+        inline void append_timestamp(std::string &out, std::int64_t time_ns) {
+            thread_local std::time_t cached_second = -1;
+            thread_local char cached[32];
+            const std::time_t second = static_cast<std::time_t>(time_ns / 1'000'000'000);
+            if (second != cached_second) {
+                std::tm tm{};
+                gmtime_r(&second, &tm);
+                std::strftime(cached, sizeof(cached), "ts=%Y-%m-%dT%H:%M:%S.", &tm);
+                cached_second = second;
+            }
+            const auto millis = static_cast<unsigned>(time_ns / 1'000'000 % 1000);
+            out.append(cached);
+            out.push_back(static_cast<char>('0' + millis / 100));
+            out.push_back(static_cast<char>('0' + millis / 10 % 10));
+            out.push_back(static_cast<char>('0' + millis % 10));
+            out += "Z ";
+        }
+
+        /**
+         * @brief Bounded MPSC queue of log lines (Vyukov's sequence-numbered ring).
+         *
+         * Producers claim a slot with one CAS on `head_` and publish it through the slot's
+         * sequence number; the single consumer never contends with them on a shared counter.
+         * `stop()` sets the `closed` bit of `head_`, so a producer that saw the logger running
+         * either claimed its slot before (and the writer waits for it) or fails its CAS and
+         * writes synchronously.
+         */
+        class logger {
+            static constexpr std::size_t mask = LOG_RING_SIZE - 1;
+            static constexpr std::size_t batch_bytes = 64 * 1024;
+            static constexpr auto idle_wait = std::chrono::milliseconds(10);
+            static constexpr std::size_t closed = std::size_t(1) << (sizeof(std::size_t) * 8 - 1);
+
+            std::unique_ptr<entry[]> ring_ = std::make_unique<entry[]>(LOG_RING_SIZE);
+            alignas(64) std::atomic<std::size_t> head_{0};
+            alignas(64) std::size_t tail_ = 0;
+            alignas(64) std::atomic<std::uint64_t> dropped_{0};
+            std::atomic<bool> running_{false};
+            std::atomic<bool> stopping_{false};
+            std::size_t closed_at_ = 0;  // slots claimed before stop(), all drained before the writer exits
+            int access_fd_ = -1;
+            bool owns_access_fd_ = false;
+            std::thread writer_;
+
+            int fd_of(sink s) const noexcept { return s == sink::access ? access_fd_ : STDERR_FILENO; }
+
+            static void render(std::string &out, const entry &e) {
+                append_timestamp(out, e.time_ns);
+                out.append(e.text, e.size);
+                out.push_back('\n');
+            }
+
+            /// @brief Move everything published so far into the batches; returns the number of lines.
+            std::size_t drain(std::string &access, std::string &errors) {
+                std::size_t lines = 0;
+                while (true) {
+                    entry &e = ring_[tail_ & mask];
+                    if (e.sequence.load(std::memory_order_acquire) != tail_ + 1) break;
+                    const sink target = e.target;
+                    std::string &batch = target == sink::access ? access : errors;
+                    render(batch, e);
+                    e.sequence.store(tail_ + LOG_RING_SIZE, std::memory_order_release);  // slot is free again
+                    ++tail_;
+                    ++lines;
+                    if (batch.size() >= batch_bytes) {
+                        write_all(fd_of(target), batch);
+                        batch.clear();
+                    }
+                }
+                return lines;
+            }
+
+            void run() {
+                std::string access, errors;
+                access.reserve(batch_bytes + entry::capacity + 64);
+                errors.reserve(batch_bytes + entry::capacity + 64);
+                while (true) {
+                    // Read the flag before draining so nothing published before stop() is left behind
+                    const bool stopping = stopping_.load(std::memory_order_acquire);
+                    const std::size_t lines = drain(access, errors);
+                    if (!access.empty()) write_all(access_fd_, access);
+                    if (!errors.empty()) write_all(STDERR_FILENO, errors);
+                    access.clear();
+                    errors.clear();
+                    if (lines == 0) {
+                        // A slot claimed just before stop() may still be being filled
+                        if (stopping && tail_ == closed_at_) return;
+                        std::this_thread::sleep_for(idle_wait);
+                    }
+                }
+            }
+
+        public:
+            logger() {
+                for (std::size_t i = 0; i < LOG_RING_SIZE; ++i) {
+                    ring_[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            ~logger() { stop(); }
+
+            logger(const logger &) = delete;
+            logger &operator=(const logger &) = delete;
+
+            void start(std::string_view access_log) {
+                if (running_.load(std::memory_order_relaxed)) return;
+                if (access_log == "-") {
+                    access_fd_ = STDOUT_FILENO;
+                } else if (!access_log.empty()) {
+                    const std::string path(access_log);
+                    access_fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+                    if (access_fd_ < 0) {
+                        throw std::runtime_error("Cannot open access log '" + path + "': " + std::strerror(errno));
+                    }
+                    owns_access_fd_ = true;
+                }
+                stopping_.store(false, std::memory_order_relaxed);
+                head_.fetch_and(~closed, std::memory_order_relaxed);
+                writer_ = std::thread([this] { run(); });
+                running_.store(true, std::memory_order_release);
+            }
+
+            /// @brief Write out every queued line and join the writer thread; call once producers are done.
+            void stop() {
+                if (!running_.exchange(false, std::memory_order_acq_rel)) return;
+                closed_at_ = head_.fetch_or(closed, std::memory_order_acq_rel) & ~closed;
+                stopping_.store(true, std::memory_order_release);
+                writer_.join();
+                if (owns_access_fd_) ::close(access_fd_);
+                owns_access_fd_ = false;
+                access_fd_ = -1;
+            }
+
+            [[nodiscard]] bool access_enabled() const noexcept { return access_fd_ >= 0; }
+
+            [[nodiscard]] std::uint64_t dropped() const noexcept {
+                return dropped_.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Queue one line for @p s; @p fill writes the text into `(char *buffer, size_t capacity)`
+             *        and returns its length.
+             */
+            template<typename Fill>
+            void push(sink s, Fill &&fill) {
+                if (s == sink::access && access_fd_ < 0) return;
+                const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+
+                const auto write_now = [&] {
+                    entry e;
+                    e.time_ns = now;
+                    e.size = static_cast<std::uint16_t>(fill(e.text, entry::capacity));
+                    std::string line;
+                    render(line, e);
+                    write_all(fd_of(s), line);
+                };
+                if (!running_.load(std::memory_order_acquire)) return write_now();
+
+                std::size_t pos = head_.load(std::memory_order_relaxed);
+                entry *e;
+                while (true) {
+                    if (pos & closed) return write_now();  // stop() raced with us: nobody drains the ring now
+                    e = &ring_[pos & mask];
+                    const std::size_t seq = e->sequence.load(std::memory_order_acquire);
+                    const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                    if (diff == 0) {
+                        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                    } else if (diff < 0) {
+                        dropped_.fetch_add(1, std::memory_order_relaxed);  // full: the writer is behind
+                        return;
+                    } else {
+                        pos = head_.load(std::memory_order_relaxed);
+                    }
+                }
+                e->time_ns = now;
+                e->target = s;
+                e->size = static_cast<std::uint16_t>(fill(e->text, entry::capacity));
+                e->sequence.store(pos + 1, std::memory_order_release);
+            }
+        };
+
+        inline logger &instance() {
+            static logger l;
+            return l;
+        }
+
+        /// @brief Bounded appender over a slot's text buffer; silently truncates.
+        struct line_writer {
+            char *out;
+            std::size_t capacity;
+            std::size_t size = 0;
+
+            line_writer &raw(std::string_view s) noexcept {
+                const std::size_t n = std::min(s.size(), capacity - size);
+                std::memcpy(out + size, s.data(), n);
+                size += n;
+                return *this;
+            }
+
+            /// @brief Double-quoted logfmt value with `"`, `\` and control characters escaped.
+            line_writer &quoted(std::string_view s) noexcept {
+                raw("\"");
+                for (const char c: s) {
+                    if (capacity - size < 3) break;
+                    if (c == '"' || c == '\\') {
+                        out[size++] = '\\';
+                        out[size++] = c;
+                    } else if (static_cast<unsigned char>(c) < 0x20) {
+                        out[size++] = ' ';
+                    } else {
+                        out[size++] = c;
+                    }
+                }
+                return raw("\"");
+            }
+
+            line_writer &number(std::uint64_t v) noexcept {
+                const auto [ptr, ec] = std::to_chars(out + size, out + capacity, v);
+                if (ec == std::errc{}) size = static_cast<std::size_t>(ptr - out);
+                return *this;
+            }
+        };
+
+        inline void message(std::string_view level, std::string_view msg) {
+            instance().push(sink::error, [&](char *out, std::size_t capacity) {
+                return line_writer{out, capacity}.raw("level=").raw(level).raw(" msg=").quoted(msg).size;
+            });
+        }
+    }
+
+    /// @brief Start the writer thread; @p access_log is a path, `-` for stdout or empty for no access log.
+    /// @throws std::runtime_error if the access log cannot be opened.
+    inline void start(std::string_view access_log = ACCESS_LOG) { detail::instance().start(access_log); }
+
+    /// @brief Flush every queued line and stop the writer thread.
+    inline void stop() { detail::instance().stop(); }
+
+    [[nodiscard]] inline bool access_enabled() noexcept { return detail::instance().access_enabled(); }
+
+    /// @brief Lines lost because the ring was full.
+    [[nodiscard]] inline std::uint64_t dropped() noexcept { return detail::instance().dropped(); }
+
+    /// @brief Queue one access line for a completed (or aborted) response.
+    inline void access(std::string_view ip, std::string_view method, std::string_view route, unsigned status,
+                       std::uint64_t bytes, std::chrono::steady_clock::duration latency) {
+        detail::instance().push(sink::access, [&](char *out, std::size_t capacity) {
+            return detail::line_writer{out, capacity}
+                    .raw("ip=").raw(ip)
+                    .raw(" method=").raw(method)
+                    .raw(" route=").quoted(route)
+                    .raw(" status=").number(status)
+                    .raw(" bytes=").number(bytes)
+                    .raw(" latency_us=")
+                    .number(static_cast<std::uint64_t>(
+                                    std::chrono::duration_cast<std::chrono::microseconds>(latency).count()))
+                    .size;
+        });
+    }
+
+    inline void error(std::string_view msg) { detail::message("error", msg); }
+
+    inline void debug(std::string_view msg) { detail::message("debug", msg); }
+}
@@ -30,10 +30,130 @@
 #define TIMEOUT 5
 #endif
 
+#ifndef KEEP_ALIVE_TIMEOUT
+#define KEEP_ALIVE_TIMEOUT 30
+#endif
+
+#ifndef MAX_KEEP_ALIVE_REQUESTS
+#define MAX_KEEP_ALIVE_REQUESTS 1000
+#endif
+
 #ifndef PORT
 #define PORT 8080
 #endif
 
+#ifndef MAX_SESSIONS
+#define MAX_SESSIONS 10000
+#endif
+
+#ifndef THREADS
+#define THREADS 0
+#endif
+
+#ifndef JSON_ARENA_SIZE
+#define JSON_ARENA_SIZE 65536
+#endif
+
+#ifndef JSON_ARENA_MAX
+#define JSON_ARENA_MAX 8388608
+#endif
+
+#ifndef MAX_BODY_SIZE
+#define MAX_BODY_SIZE 1048576
+#endif
+
+#ifndef STREAM_BUFFER_SIZE
+#define STREAM_BUFFER_SIZE 65536
+#endif
+
+#ifndef STATIC_CACHE_SIZE
+#define STATIC_CACHE_SIZE 16777216
+#endif
+
+#ifndef STATIC_CACHE_FILE_MAX
+#define STATIC_CACHE_FILE_MAX 65536
+#endif
+
+#ifndef RESPONSE_CACHE_SIZE
+#define RESPONSE_CACHE_SIZE 33554432
+#endif
+
+#ifndef RESPONSE_CACHE_ENTRY_MAX
+#define RESPONSE_CACHE_ENTRY_MAX 1048576
+#endif
+
+#ifndef COMPRESSION_LEVEL
+#define COMPRESSION_LEVEL 6
+#endif
+
+#ifndef BROTLI_QUALITY
+#define BROTLI_QUALITY 4
+#endif
+
+#ifndef COMPRESSION_MIN_SIZE
+#define COMPRESSION_MIN_SIZE 1024
+#endif
+
 #ifndef CORS_MAX_AGE
 #define CORS_MAX_AGE 86400
 #endif
+
+#ifndef ACCESS_LOG
+#define ACCESS_LOG ""
+#endif
+
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 8192
+#endif
+
+#ifndef RATE_LIMIT_CONNECTIONS
+#define RATE_LIMIT_CONNECTIONS 0
+#endif
+
+#ifndef RATE_LIMIT_CONNECTIONS_BURST
+#define RATE_LIMIT_CONNECTIONS_BURST 0
+#endif
+
+#ifndef RATE_LIMIT_REQUESTS
+#define RATE_LIMIT_REQUESTS 0
+#endif
+
+#ifndef RATE_LIMIT_REQUESTS_BURST
+#define RATE_LIMIT_REQUESTS_BURST 0
+#endif
+
+#ifndef TLS_CERT
+#define TLS_CERT ""
+#endif
+
+#ifndef TLS_KEY
+#define TLS_KEY ""
+#endif
+
+#ifndef TLS_SESSION_CACHE
+#define TLS_SESSION_CACHE 20480
+#endif
+
+#ifndef TLS_SESSION_TIMEOUT
+#define TLS_SESSION_TIMEOUT 7200
+#endif
+
+#ifndef TLS_TICKETS
+#define TLS_TICKETS 2
+#endif
+
+#ifndef HTTP2_MAX_STREAMS
+#define HTTP2_MAX_STREAMS 100
+#endif
+
+#ifndef HTTP2_WINDOW_SIZE
+#define HTTP2_WINDOW_SIZE 1048576
+#endif
+
+#ifndef WEBSOCKET_QUEUE_LIMIT
+#define WEBSOCKET_QUEUE_LIMIT 1048576
+#endif
+
+#ifndef INTERNAL_NETWORKS
+#define INTERNAL_NETWORKS ""
+#endif
@@ -0,0 +1,283 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "sessions.hpp"
+
+
+/**
+ * @brief Request, latency and connection metrics in Prometheus text format.
+ *
+ * Every route gets a small integer id when the route map is built. Each I/O thread owns a shard
+ * holding, per route, request counts by status class and a latency histogram; the thread is the
+ * only writer of its shard, so recording a request is a handful of relaxed loads and stores on
+ * thread-private cache lines, without locks or contended read-modify-writes. `render()` sums all
+ * shards on scrape.
+ *
+ * Process-wide counters (accept errors, timeouts) change rarely and are plain atomics.
+ */
+namespace bulgogi::metrics {
+
+    /// @brief Upper bounds of the latency buckets in seconds; a final `+Inf` bucket is implied.
+    inline constexpr std::array<double, 14> buckets = {
+            0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5};
+
+    namespace detail {
+        inline constexpr std::size_t status_classes = 5;  // 1xx .. 5xx
+
+        /// @brief Add to a counter that only the owning thread writes.
+        inline void bump(std::atomic<std::uint64_t> &counter, std::uint64_t n = 1) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        struct route_cells {
+            std::array<std::atomic<std::uint64_t>, status_classes> requests{};
+            std::array<std::atomic<std::uint64_t>, buckets.size() + 1> latency{};
+            std::atomic<std::uint64_t> latency_ns{0};
+        };
+
+        struct alignas(64) shard {
+            std::unique_ptr<route_cells[]> routes;
+            std::size_t route_count;
+            std::atomic<std::uint64_t> bytes_in{0};
+            std::atomic<std::uint64_t> bytes_out{0};
+
+            explicit shard(std::size_t n) : routes(std::make_unique<route_cells[]>(n)), route_count(n) {}
+        };
+
+        struct registry {
+            std::mutex mutex;
+            std::vector<std::string> route_names;
+            std::vector<std::unique_ptr<shard>> shards;
+        };
+
+        inline registry &global() {
+            static registry r;
+            return r;
+        }
+
+        inline std::atomic<std::uint64_t> accept_errors{0};
+        inline std::atomic<std::uint64_t> timeouts{0};
+
+        /// @brief The calling thread's shard, created on first use and kept for the process lifetime.
+        inline shard &local() {
+            thread_local shard *mine = [] {
+                auto &r = global();
+                std::lock_guard lock(r.mutex);
+                r.shards.push_back(std::make_unique<shard>(r.route_names.size()));
+                return r.shards.back().get();
+            }();
+            return *mine;
+        }
+
+        /**
+         * @brief Resize the route cells of @p s to the routes registered so far, keeping its counts.
+         *
+         * A thread that recorded bytes or requests before `add_route` ran has a shard sized for
+         * fewer routes; it catches up on its first request to a newer route. Only the owning
+         * thread writes the cells, and `render()` reads them under the same mutex.
+         */
+        inline void grow(shard &s) {
+            auto &r = global();
+            std::lock_guard lock(r.mutex);
+            const std::size_t n = r.route_names.size();
+            if (n <= s.route_count) return;
+            auto cells = std::make_unique<route_cells[]>(n);
+            for (std::size_t i = 0; i < s.route_count; ++i) {
+                for (std::size_t c = 0; c < status_classes; ++c) {
+                    cells[i].requests[c].store(s.routes[i].requests[c].load(std::memory_order_relaxed),
+                                               std::memory_order_relaxed);
+                }
+                for (std::size_t b = 0; b <= buckets.size(); ++b) {
+                    cells[i].latency[b].store(s.routes[i].latency[b].load(std::memory_order_relaxed),
+                                              std::memory_order_relaxed);
+                }
+                cells[i].latency_ns.store(s.routes[i].latency_ns.load(std::memory_order_relaxed),
+                                          std::memory_order_relaxed);
+            }
+            s.routes = std::move(cells);
+            s.route_count = n;
+        }
+
+        inline void append_escaped(std::string &out, std::string_view label) {
+            for (const char c: label) {
+                if (c == '\\' || c == '"') out.push_back('\\');
+                if (c == '\n') {
+                    out += "\\n";
+                    continue;
+                }
+                out.push_back(c);
+            }
+        }
+
+        inline void append_number(std::string &out, std::uint64_t v) {
+            char buf[24];
+            const auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+            (void) ec;
+            out.append(buf, ptr);
+        }
+
+        inline void append_number(std::string &out, double v,
+                                  std::chars_format format = std::chars_format::general) {
+            char buf[32];
+            const auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), v, format);
+            (void) ec;
+            out.append(buf, ptr);
+        }
+    }
+
+    /// @brief Id of requests that matched no route.
+    inline constexpr std::uint32_t unmatched = 0;
+
+    /**
+     * @brief Register a route name and get its id; call while building the route map, before
+     *        any request is served.
+     */
+    inline std::uint32_t add_route(std::string name) {
+        auto &r = detail::global();
+        std::lock_guard lock(r.mutex);
+        if (r.route_names.empty()) r.route_names.emplace_back("unmatched");
+        r.route_names.push_back(std::move(name));
+        return static_cast<std::uint32_t>(r.route_names.size() - 1);
+    }
+
+    /// @brief Record one served request on @p route with its status code and handling time.
+    inline void observe(std::uint32_t route, unsigned status, std::chrono::steady_clock::duration elapsed) noexcept {
+        auto &s = detail::local();
+        if (route >= s.route_count) detail::grow(s);
+        if (route >= s.route_count) route = unmatched;
+        if (s.route_count == 0) return;
+        auto &cells = s.routes[route];
+
+        const std::size_t cls = status >= 100 && status < 600 ? status / 100 - 1 : detail::status_classes - 1;
+        detail::bump(cells.requests[cls]);
+
+        const auto ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        const double seconds = static_cast<double>(ns) * 1e-9;
+        std::size_t b = 0;
+        while (b < buckets.size() && seconds > buckets[b]) ++b;
+        detail::bump(cells.latency[b]);
+        detail::bump(cells.latency_ns, ns);
+    }
+
+    inline void add_bytes_in(std::size_t n) noexcept { detail::bump(detail::local().bytes_in, n); }
+
+    inline void add_bytes_out(std::size_t n) noexcept { detail::bump(detail::local().bytes_out, n); }
+
+    inline void count_accept_error() noexcept { detail::accept_errors.fetch_add(1, std::memory_order_relaxed); }
+
+    inline void count_timeout() noexcept { detail::timeouts.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief Append a single unlabelled sample with its `HELP` and `TYPE` lines to @p out.
+    inline void append_scalar(std::string &out, std::string_view name, std::string_view type, std::string_view help,
+                              std::uint64_t value) {
+        out.append("# HELP ").append(name).append(" ").append(help).append("\n# TYPE ").append(name)
+                .append(" ").append(type).append("\n").append(name).append(" ");
+        detail::append_number(out, value);
+        out.push_back('\n');
+    }
+
+    /**
+     * @brief Append the request, byte and connection metrics in Prometheus text exposition format
+     *        (version 0.0.4) to @p out.
+     *
+     * Counters owned by optional features are appended by the `/metrics` view with `append_scalar`,
+     * so this module does not depend on them.
+     */
+    inline void render(std::string &out) {
+        auto &r = detail::global();
+        std::lock_guard lock(r.mutex);
+        const std::size_t routes = r.route_names.size();
+
+        // Sum the shards first so every series below is taken from one consistent pass
+        std::vector<std::array<std::uint64_t, detail::status_classes>> requests(routes);
+        std::vector<std::array<std::uint64_t, buckets.size() + 1>> latency(routes);
+        std::vector<std::uint64_t> latency_ns(routes);
+        std::uint64_t bytes_in = 0, bytes_out = 0;
+        for (const auto &s: r.shards) {
+            for (std::size_t i = 0; i < s->route_count && i < routes; ++i) {
+                for (std::size_t c = 0; c < detail::status_classes; ++c) {
+                    requests[i][c] += s->routes[i].requests[c].load(std::memory_order_relaxed);
+                }
+                for (std::size_t b = 0; b <= buckets.size(); ++b) {
+                    latency[i][b] += s->routes[i].latency[b].load(std::memory_order_relaxed);
+                }
+                latency_ns[i] += s->routes[i].latency_ns.load(std::memory_order_relaxed);
+            }
+            bytes_in += s->bytes_in.load(std::memory_order_relaxed);
+            bytes_out += s->bytes_out.load(std::memory_order_relaxed);
+        }
+
+        const auto series = [&](std::string_view name, std::size_t route) {
+            out.append(name).append("{route=\"");
+            detail::append_escaped(out, r.route_names[route]);
+            out.push_back('"');
+        };
+
+        out += "# HELP bulgogi_requests_total Requests served, by route and status class.\n"
+               "# TYPE bulgogi_requests_total counter\n";
+        static constexpr std::string_view classes[] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+        for (std::size_t i = 0; i < routes; ++i) {
+            for (std::size_t c = 0; c < detail::status_classes; ++c) {
+                if (!requests[i][c]) continue;
+                series("bulgogi_requests_total", i);
+                out.append(",code=\"").append(classes[c]).append("\"} ");
+                detail::append_number(out, requests[i][c]);
+                out.push_back('\n');
+            }
+        }
+
+        out += "# HELP bulgogi_request_duration_seconds Time from a parsed request to its response being ready.\n"
+               "# TYPE bulgogi_request_duration_seconds histogram\n";
+        for (std::size_t i = 0; i < routes; ++i) {
+            std::uint64_t cumulative = 0;
+            for (std::size_t b = 0; b <= buckets.size(); ++b) cumulative += latency[i][b];
+            if (!cumulative) continue;
+
+            cumulative = 0;
+            for (std::size_t b = 0; b <= buckets.size(); ++b) {
+                cumulative += latency[i][b];
+                series("bulgogi_request_duration_seconds_bucket", i);
+                out += ",le=\"";
+                if (b < buckets.size()) detail::append_number(out, buckets[b], std::chars_format::fixed);
+                else out += "+Inf";
+                out += "\"} ";
+                detail::append_number(out, cumulative);
+                out.push_back('\n');
+            }
+            series("bulgogi_request_duration_seconds_sum", i);
+            out += "} ";
+            detail::append_number(out, static_cast<double>(latency_ns[i]) * 1e-9);
+            out.push_back('\n');
+            series("bulgogi_request_duration_seconds_count", i);
+            out += "} ";
+            detail::append_number(out, cumulative);
+            out.push_back('\n');
+        }
+
+        append_scalar(out, "bulgogi_received_bytes_total", "counter", "Bytes of requests read.", bytes_in);
+        append_scalar(out, "bulgogi_sent_bytes_total", "counter", "Bytes of responses written.", bytes_out);
+        append_scalar(out, "bulgogi_active_sessions", "gauge", "Connections currently being served.",
+                      sessions::active());
+        append_scalar(out, "bulgogi_peak_sessions", "gauge", "Highest number of concurrent connections.",
+                      sessions::peak());
+        append_scalar(out, "bulgogi_max_sessions", "gauge", "Configured MAX_SESSIONS.", sessions::limit);
+        append_scalar(out, "bulgogi_rejected_sessions_total", "counter", "Connections answered with 503 at the limit.",
+                      sessions::rejected());
+        append_scalar(out, "bulgogi_accept_errors_total", "counter", "Failed accept() calls.",
+                      detail::accept_errors.load(std::memory_order_relaxed));
+        append_scalar(out, "bulgogi_timeouts_total", "counter", "Requests or responses that hit TIMEOUT.",
+                      detail::timeouts.load(std::memory_order_relaxed));
+    }
+}
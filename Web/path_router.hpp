@@ -0,0 +1,266 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace bulgogi {
+
+    /**
+     * @brief Values captured from a matched path pattern.
+     *
+     * Both names and values are `std::string_view`s: names point into the router, values point
+     * into the request target, so they are valid for the duration of the handler call only.
+     * Copy them into a `std::string` if they must outlive the request.
+     */
+    class path_params {
+    public:
+        /// @brief Maximum number of captures in a single pattern.
+        static constexpr std::size_t capacity = 8;
+
+        using value_type = std::pair<std::string_view, std::string_view>;
+
+        /**
+         * @brief Raw (undecoded) value of a capture.
+         * @param name Capture name as written in the pattern, e.g. `"id"` for `{id:int}`.
+         * @return The captured text, or std::nullopt if the pattern has no such capture.
+         */
+        [[nodiscard]] std::optional<std::string_view> get(std::string_view name) const noexcept {
+            for (std::size_t i = 0; i < size_; ++i) {
+                if (items_[i].first == name) return items_[i].second;
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Capture converted to an arithmetic type with `std::from_chars`.
+         * @return The parsed value, or std::nullopt if absent, malformed or out of range.
+         */
+        template<typename T>
+        requires std::is_arithmetic_v<T>
+        [[nodiscard]] std::optional<T> get(std::string_view name) const noexcept {
+            const auto raw = get(name);
+            if (!raw) return std::nullopt;
+            T value{};
+            const auto [ptr, ec] = std::from_chars(raw->data(), raw->data() + raw->size(), value);
+            if (ec != std::errc{} || ptr != raw->data() + raw->size()) return std::nullopt;
+            return value;
+        }
+
+        /// @brief Raw value of a capture, or an empty view if absent.
+        [[nodiscard]] std::string_view operator[](std::string_view name) const noexcept {
+            return get(name).value_or(std::string_view{});
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+        [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+        [[nodiscard]] const value_type *begin() const noexcept { return items_.data(); }
+
+        [[nodiscard]] const value_type *end() const noexcept { return items_.data() + size_; }
+
+    private:
+        template<typename> friend class path_router;
+
+        void push(std::string_view name, std::string_view value) noexcept {
+            items_[size_++] = {name, value};
+        }
+
+        void truncate(std::size_t n) noexcept { size_ = n; }
+
+        std::array<value_type, capacity> items_{};
+        std::size_t size_ = 0;
+    };
+
+    /**
+     * @brief Segment-wise radix tree for routes with path captures.
+     *
+     * Patterns are written like `function_map` keys (no leading slash), one segment per `/`:
+     * - `users`        — literal segment;
+     * - `{slug}`       — any non-empty segment;
+     * - `{id:int}`     — a segment of decimal digits with an optional leading `-`;
+     * - `{*rest}`      — the remainder of the path including slashes; last segment only.
+     *
+     * Each tree level is one path segment, so matching is linear in the path length. Literal
+     * children are kept sorted and binary-searched; at each level literals are tried before
+     * `int` captures, which are tried before plain captures, and the wildcard comes last. A failed
+     * branch backtracks, so `users/me` and `users/{id:int}` can coexist.
+     *
+     * The router is built once at start-up and only read afterwards; `match()` does not allocate.
+     *
+     * @tparam Value Payload stored per pattern (e.g. a handler function pointer).
+     */
+    template<typename Value>
+    class path_router {
+        enum class capture : std::uint8_t { integer, any };
+
+        struct node;
+
+        struct param_edge {
+            std::string name;
+            capture type;
+            std::unique_ptr<node> child;
+        };
+
+        struct node {
+            std::vector<std::pair<std::string, std::unique_ptr<node>>> literals;  // sorted by key
+            std::vector<param_edge> params;                                        // integer first
+            std::string wildcard_name;
+            std::optional<Value> wildcard;
+            std::optional<Value> value;
+        };
+
+        node root_;
+        std::size_t size_ = 0;
+
+        static bool is_integer(std::string_view seg) noexcept {
+            if (!seg.empty() && seg.front() == '-') seg.remove_prefix(1);
+            return !seg.empty() && std::all_of(seg.begin(), seg.end(), [](char c) { return c >= '0' && c <= '9'; });
+        }
+
+        static bool accepts(capture type, std::string_view seg) noexcept {
+            if (seg.empty()) return false;
+            return type == capture::any || is_integer(seg);
+        }
+
+        const Value *match(const node &n, std::string_view path, std::size_t pos, path_params &params) const noexcept {
+            const std::size_t end = path.size() + 1;  // position after the last segment
+            if (pos == end) return n.value ? &*n.value : nullptr;
+
+            std::size_t seg_end = path.find('/', pos);
+            if (seg_end == std::string_view::npos) seg_end = path.size();
+            const std::string_view seg = path.substr(pos, seg_end - pos);
+            const std::size_t next = seg_end + 1;
+
+            const auto it = std::lower_bound(n.literals.begin(), n.literals.end(), seg,
+                                             [](const auto &e, std::string_view k) { return e.first < k; });
+            if (it != n.literals.end() && it->first == seg) {
+                if (const Value *v = match(*it->second, path, next, params)) return v;
+            }
+
+            for (const auto &edge: n.params) {
+                if (!accepts(edge.type, seg)) continue;
+                const std::size_t mark = params.size();
+                params.push(edge.name, seg);
+                if (const Value *v = match(*edge.child, path, next, params)) return v;
+                params.truncate(mark);
+            }
+
+            if (n.wildcard) {
+                params.push(n.wildcard_name, path.substr(pos));
+                return &*n.wildcard;
+            }
+            return nullptr;
+        }
+
+    public:
+        /**
+         * @brief Register a pattern. Re-registering the same pattern replaces its value.
+         * @throws std::invalid_argument on malformed patterns, a wildcard that is not the last
+         *         segment, or more than `path_params::capacity` captures.
+         */
+        void add(std::string_view pattern, Value value) {
+            const std::string original(pattern);
+            if (!pattern.empty() && pattern.front() == '/') pattern.remove_prefix(1);
+
+            node *n = &root_;
+            std::size_t captures = 0;
+            std::size_t pos = 0;
+            while (true) {
+                std::size_t seg_end = pattern.find('/', pos);
+                const bool last = seg_end == std::string_view::npos;
+                if (last) seg_end = pattern.size();
+                const std::string_view seg = pattern.substr(pos, seg_end - pos);
+
+                if (seg.size() >= 2 && seg.front() == '{' && seg.back() == '}') {
+                    std::string_view spec = seg.substr(1, seg.size() - 2);
+                    if (++captures > path_params::capacity) {
+                        throw std::invalid_argument("path_router: too many captures in '" + original + "'");
+                    }
+
+                    if (!spec.empty() && spec.front() == '*') {
+                        if (!last || spec.size() == 1) {
+                            throw std::invalid_argument("path_router: bad wildcard in '" + original + "'");
+                        }
+                        n->wildcard_name = std::string(spec.substr(1));
+                        if (!n->wildcard) ++size_;
+                        n->wildcard = std::move(value);
+                        return;
+                    }
+
+                    capture type = capture::any;
+                    if (const auto colon = spec.find(':'); colon != std::string_view::npos) {
+                        const std::string_view type_name = spec.substr(colon + 1);
+                        if (type_name == "int") type = capture::integer;
+                        else if (type_name != "str") {
+                            throw std::invalid_argument("path_router: unknown capture type in '" + original + "'");
+                        }
+                        spec = spec.substr(0, colon);
+                    }
+                    if (spec.empty()) {
+                        throw std::invalid_argument("path_router: unnamed capture in '" + original + "'");
+                    }
+
+                    auto edge = std::find_if(n->params.begin(), n->params.end(), [&](const param_edge &e) {
+                        return e.type == type && e.name == spec;
+                    });
+                    if (edge == n->params.end()) {
+                        param_edge fresh{std::string(spec), type, std::make_unique<node>()};
+                        edge = n->params.insert(
+                                std::find_if(n->params.begin(), n->params.end(),
+                                             [&](const param_edge &e) { return e.type > type; }),
+                                std::move(fresh));
+                    }
+                    n = edge->child.get();
+                } else {
+                    if (seg.find_first_of("{}") != std::string_view::npos) {
+                        throw std::invalid_argument("path_router: malformed segment in '" + original + "'");
+                    }
+                    auto it = std::lower_bound(n->literals.begin(), n->literals.end(), seg,
+                                               [](const auto &e, std::string_view k) { return e.first < k; });
+                    if (it == n->literals.end() || it->first != seg) {
+                        it = n->literals.emplace(it, std::string(seg), std::make_unique<node>());
+                    }
+                    n = it->second.get();
+                }
+
+                if (last) break;
+                pos = seg_end + 1;
+            }
+
+            if (!n->value) ++size_;
+            n->value = std::move(value);
+        }
+
+        /**
+         * @brief Match a request path against the registered patterns.
+         * @param path Path without query string; a leading `/` is ignored.
+         * @param params Receives the captures of the matched pattern (cleared first).
+         * @return Pointer to the stored value, or `nullptr` if no pattern matches.
+         */
+        [[nodiscard]] const Value *match(std::string_view path, path_params &params) const noexcept {
+            params.truncate(0);
+            if (size_ == 0) return nullptr;
+            if (!path.empty() && path.front() == '/') path.remove_prefix(1);
+            return match(root_, path, 0, params);
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+        [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    };
+}
@@ -0,0 +1,237 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+namespace bulgogi {
+
+    namespace detail {
+        inline int hex_value(char c) noexcept {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        inline bool needs_decoding(std::string_view s) noexcept {
+            return s.find_first_of("%+") != std::string_view::npos;
+        }
+
+        /**
+         * @brief Decode one `application/x-www-form-urlencoded` character starting at @p i.
+         * @return The decoded character; @p i is advanced past the consumed input.
+         *         Malformed `%` escapes are passed through literally.
+         */
+        inline char decode_at(std::string_view s, std::size_t &i) noexcept {
+            const char c = s[i++];
+            if (c == '+') return ' ';
+            if (c == '%' && i + 1 < s.size()) {
+                const int hi = hex_value(s[i]);
+                const int lo = hex_value(s[i + 1]);
+                if (hi >= 0 && lo >= 0) {
+                    i += 2;
+                    return static_cast<char>(hi * 16 + lo);
+                }
+            }
+            return c;
+        }
+
+        /// @brief Compare an encoded query key with a plain key without materialising it.
+        inline bool decoded_equals(std::string_view encoded, std::string_view plain) noexcept {
+            if (!needs_decoding(encoded)) return encoded == plain;
+            std::size_t i = 0, j = 0;
+            while (i < encoded.size()) {
+                if (j == plain.size() || decode_at(encoded, i) != plain[j++]) return false;
+            }
+            return j == plain.size();
+        }
+    }
+
+    /**
+     * @brief Query string parsed once per request into a fixed array of views.
+     *
+     * Construction splits the query part of a request target on `&` and `=` without copying;
+     * every lookup afterwards is a scan over at most `capacity` pairs instead of a rescan of the
+     * target. Keys and values stay `std::string_view`s into the target, and percent/`+` decoding
+     * only happens for values that actually contain `%` or `+`:
+     * - the first such lookup decodes all escaped values at once into a single buffer sized to
+     *   the whole query, each at its own offset in the query, so decoded views stay valid for
+     *   the lifetime of the `query_view` (the buffer is addressed by offsets, so copies and
+     *   moves keep working);
+     * - values without escapes are returned as views into the target with no allocation at all.
+     *
+     * Only the first `capacity` pairs are stored. Lookups still see the rest: a key that is not
+     * among them is searched for in the unparsed remainder of the query (`truncated()` tells
+     * whether there is one), so no parameter is lost, it is just found by a linear scan. Iteration
+     * with `begin()`/`end()` covers the stored pairs only.
+     *
+     * Lookups return the first occurrence of a key; a key without `=` (e.g. `?verbose`) has an
+     * empty value.
+     *
+     * The view must not outlive the request target it was built from.
+     */
+    class query_view {
+    public:
+        /// @brief Maximum number of key/value pairs kept per request.
+        static constexpr std::size_t capacity = 32;
+
+        query_view() = default;
+
+        /// @brief Parse the query part of @p target (everything after the first `?`).
+        explicit query_view(std::string_view target) noexcept {
+            const auto q = target.find('?');
+            if (q == std::string_view::npos) return;
+            query_ = target.substr(q + 1);
+            std::string_view query = query_;
+
+            while (!query.empty() && size_ < capacity) {
+                if (const auto pair = next_pair(query)) items_[size_++] = *pair;
+            }
+            rest_ = query;
+        }
+
+        /// @brief Value exactly as it appears in the target, without decoding.
+        [[nodiscard]] std::optional<std::string_view> raw(std::string_view key) const noexcept {
+            const std::size_t i = index_of(key);
+            if (i < size_) return items_[i].second;
+            return find_in_rest(key);
+        }
+
+        /**
+         * @brief Decoded value of @p key.
+         * @return A view that is valid as long as this `query_view`, or std::nullopt if absent.
+         */
+        [[nodiscard]] std::optional<std::string_view> get(std::string_view key) const {
+            const std::size_t i = index_of(key);
+            if (i == size_) {
+                const auto value = find_in_rest(key);
+                if (!value || !detail::needs_decoding(*value)) return value;
+                return decode_in_place(*value);
+            }
+            if (!detail::needs_decoding(items_[i].second)) return items_[i].second;
+
+            if (!decoded_ready_) decode_all();
+            return std::string_view(decoded_).substr(decoded_spans_[i].first, decoded_spans_[i].second);
+        }
+
+        /**
+         * @brief Typed value of @p key.
+         *
+         * Arithmetic types are parsed with `std::from_chars` and must consume the whole value.
+         * `bool` accepts `1/0`, `true/false`, `yes/no` and `on/off`; a present key with an empty
+         * value (e.g. `?verbose`) counts as `true`.
+         *
+         * @return The parsed value, or std::nullopt if absent or malformed.
+         */
+        template<typename T>
+        requires std::is_arithmetic_v<T>
+        [[nodiscard]] std::optional<T> get(std::string_view key) const {
+            const auto value = get(key);
+            if (!value) return std::nullopt;
+
+            if constexpr (std::is_same_v<T, bool>) {
+                const std::string_view v = *value;
+                if (v.empty() || v == "1" || v == "true" || v == "yes" || v == "on") return true;
+                if (v == "0" || v == "false" || v == "no" || v == "off") return false;
+                return std::nullopt;
+            } else {
+                T out{};
+                const auto [ptr, ec] = std::from_chars(value->data(), value->data() + value->size(), out);
+                if (ec != std::errc{} || ptr != value->data() + value->size()) return std::nullopt;
+                return out;
+            }
+        }
+
+        [[nodiscard]] bool contains(std::string_view key) const noexcept {
+            return raw(key).has_value();
+        }
+
+        /// @brief Number of pairs stored (at most `capacity`).
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+        /// @brief True if the query had more than `capacity` pairs and lookups may scan the rest.
+        [[nodiscard]] bool truncated() const noexcept { return !rest_.empty(); }
+
+        [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+        /// @brief Raw (undecoded) pairs in order of appearance.
+        [[nodiscard]] const std::pair<std::string_view, std::string_view> *begin() const noexcept {
+            return items_.data();
+        }
+
+        [[nodiscard]] const std::pair<std::string_view, std::string_view> *end() const noexcept {
+            return items_.data() + size_;
+        }
+
+    private:
+        /// @brief Split the next `&`-separated pair off @p query; std::nullopt for an empty pair.
+        static std::optional<std::pair<std::string_view, std::string_view>> next_pair(std::string_view &query) noexcept {
+            const auto amp = query.find('&');
+            const std::string_view pair = query.substr(0, amp);
+            query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
+            if (pair.empty()) return std::nullopt;
+
+            const auto eq = pair.find('=');
+            if (eq == std::string_view::npos) return std::pair{pair, std::string_view{}};
+            return std::pair{pair.substr(0, eq), pair.substr(eq + 1)};
+        }
+
+        [[nodiscard]] std::size_t index_of(std::string_view key) const noexcept {
+            std::size_t i = 0;
+            while (i < size_ && !detail::decoded_equals(items_[i].first, key)) ++i;
+            return i;
+        }
+
+        /// @brief Linear scan over the pairs past `capacity`, for lookups that missed the array.
+        [[nodiscard]] std::optional<std::string_view> find_in_rest(std::string_view key) const noexcept {
+            std::string_view query = rest_;
+            while (!query.empty()) {
+                const auto pair = next_pair(query);
+                if (pair && detail::decoded_equals(pair->first, key)) return pair->second;
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Decode @p value (a view into the query) at its own offset in the decoded buffer.
+         *
+         * The buffer is sized to the whole query once, and decoded text is never longer than its
+         * source, so values never overlap and decoding one again rewrites the same bytes.
+         */
+        std::string_view decode_in_place(std::string_view value) const {
+            if (decoded_.size() != query_.size()) decoded_.resize(query_.size());
+            const std::size_t start = static_cast<std::size_t>(value.data() - query_.data());
+            std::size_t out = start;
+            for (std::size_t i = 0; i < value.size();) decoded_[out++] = detail::decode_at(value, i);
+            return std::string_view(decoded_).substr(start, out - start);
+        }
+
+        /// @brief Decode every stored escaped value once; their views stay valid afterwards.
+        void decode_all() const {
+            for (std::size_t k = 0; k < size_; ++k) {
+                const std::string_view value = items_[k].second;
+                if (!detail::needs_decoding(value)) continue;
+                const std::string_view decoded = decode_in_place(value);
+                decoded_spans_[k] = {static_cast<std::size_t>(decoded.data() - decoded_.data()), decoded.size()};
+            }
+            decoded_ready_ = true;
+        }
+
+        std::array<std::pair<std::string_view, std::string_view>, capacity> items_{};
+        std::size_t size_ = 0;
+        std::string_view query_;  // everything after `?`
+        std::string_view rest_;   // unparsed pairs past `capacity`
+        mutable std::string decoded_;
+        mutable std::array<std::pair<std::size_t, std::size_t>, capacity> decoded_spans_{};  // offset, length
+        mutable bool decoded_ready_ = false;
+    };
+}
@@ -0,0 +1,243 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <boost/asio/ip/address.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "marcos.hpp"
+#include "canned_response.hpp"
+
+
+/**
+ * @brief Per-client admission control with token buckets.
+ *
+ * Two independent limits, both off by default:
+ * - `RATE_LIMIT_CONNECTIONS`: new connections per second per client, checked right after
+ *   `accept()`. A client over the limit is answered with a preformatted `429` and closed before
+ *   a session is created.
+ * - `RATE_LIMIT_REQUESTS`: requests per second per client (per client and route with
+ *   `RATE_LIMIT_PER_ROUTE`), checked before routing. A request over the limit is answered with a
+ *   preformatted `429` and the connection is kept.
+ *
+ * Each limit refills at its rate and holds up to its burst (`*_BURST`, 0 for the rate itself).
+ * Clients are keyed by IPv4 address, or by the `/64` prefix for IPv6, where one host usually
+ * owns the whole prefix.
+ *
+ * Buckets live in a table split into `shard_count` shards, each behind its own mutex, so threads
+ * only contend when their clients hash to the same shard. A bucket left alone long enough to
+ * refill completely is indistinguishable from a missing one, so each shard drops those during
+ * a periodic sweep and memory follows the number of recently active clients.
+ */
+namespace bulgogi::rate_limit {
+
+    /// @brief A client address (IPv6 form, IPv6 truncated to /64) plus an optional route id.
+    struct client_key {
+        std::array<unsigned char, 16> address{};
+        std::uint32_t route = 0;
+
+        client_key() = default;
+
+        explicit client_key(const boost::asio::ip::address &ip, std::uint32_t route_id = 0) : route(route_id) {
+            if (ip.is_v4()) {
+                const auto v4 = ip.to_v4().to_bytes();
+                address[10] = address[11] = 0xFF;  // ::ffff:a.b.c.d
+                std::copy(v4.begin(), v4.end(), address.begin() + 12);
+            } else {
+                const auto v6 = ip.to_v6();
+                address = v6.to_bytes();
+                if (!v6.is_v4_mapped()) std::fill(address.begin() + 8, address.end(), 0);
+            }
+        }
+
+        bool operator==(const client_key &) const = default;
+    };
+
+    struct client_key_hash {
+        std::size_t operator()(const client_key &key) const noexcept {
+            std::uint64_t hi, lo;
+            std::memcpy(&hi, key.address.data(), 8);
+            std::memcpy(&lo, key.address.data() + 8, 8);
+            // splitmix64 finaliser over the folded key
+            std::uint64_t x = hi ^ (lo * 0x9E3779B97F4A7C15ull) ^ (static_cast<std::uint64_t>(key.route) << 32);
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return static_cast<std::size_t>(x ^ (x >> 31));
+        }
+    };
+
+    /**
+     * @brief A sharded table of token buckets, one per `client_key`.
+     *
+     * A rate of 0 disables the table: `acquire()` always succeeds and nothing is stored.
+     */
+    class token_buckets {
+    public:
+        using clock = std::chrono::steady_clock;
+        static constexpr std::size_t shard_count = 64;
+
+        /**
+         * @param rate Tokens added per second.
+         * @param burst Bucket capacity; 0 for @p rate (at least 1).
+         */
+        token_buckets(double rate, double burst)
+                : rate_per_ns_(rate / 1e9), burst_(std::max(1.0, burst > 0 ? burst : rate)),
+                  idle_ns_(rate > 0 ? static_cast<std::int64_t>(std::ceil(burst_ / rate * 1e9)) : 0),
+                  sweep_ns_(std::max<std::int64_t>(idle_ns_, 1'000'000'000)),
+                  retry_after_(rate > 0 ? static_cast<unsigned>(std::max(1.0, std::ceil(1.0 / rate))) : 0) {}
+
+        token_buckets(const token_buckets &) = delete;
+        token_buckets &operator=(const token_buckets &) = delete;
+
+        [[nodiscard]] bool enabled() const noexcept { return rate_per_ns_ > 0; }
+
+        /// @brief Seconds until an empty bucket holds a token again, for `Retry-After`.
+        [[nodiscard]] unsigned retry_after() const noexcept { return retry_after_; }
+
+        /// @brief Take one token from @p key's bucket; false if it is empty.
+        bool acquire(const client_key &key, clock::time_point now = clock::now()) {
+            if (!enabled()) return true;
+            const std::size_t hash = client_key_hash{}(key);
+            auto &s = shards_[(hash >> 7) % shard_count];  // low bits pick the map bucket
+            const std::int64_t t = now.time_since_epoch().count();
+
+            std::lock_guard lock(s.mutex);
+            if (t - s.swept >= sweep_ns_) sweep(s, t);
+
+            auto [it, fresh] = s.buckets.try_emplace(key, bucket{burst_, t});
+            auto &b = it->second;
+            if (!fresh) {
+                b.tokens = std::min(burst_, b.tokens + static_cast<double>(t - b.updated) * rate_per_ns_);
+                b.updated = t;
+            }
+            if (b.tokens < 1.0) return false;
+            b.tokens -= 1.0;
+            return true;
+        }
+
+        /// @brief Clients currently tracked; takes every shard lock in turn.
+        [[nodiscard]] std::size_t size() const {
+            std::size_t n = 0;
+            for (auto &s: shards_) {
+                std::lock_guard lock(s.mutex);
+                n += s.buckets.size();
+            }
+            return n;
+        }
+
+    private:
+        struct bucket {
+            double tokens;
+            std::int64_t updated;  // steady_clock ticks (ns)
+        };
+
+        struct alignas(64) shard {
+            mutable std::mutex mutex;
+            std::unordered_map<client_key, bucket, client_key_hash> buckets;
+            std::int64_t swept = 0;
+        };
+
+        /// @brief Drop buckets that have had time to refill completely.
+        void sweep(shard &s, std::int64_t t) const {
+            std::erase_if(s.buckets, [&](const auto &entry) { return t - entry.second.updated >= idle_ns_; });
+            s.swept = t;
+        }
+
+        double rate_per_ns_;
+        double burst_;
+        std::int64_t idle_ns_;
+        std::int64_t sweep_ns_;
+        unsigned retry_after_;
+        std::array<shard, shard_count> shards_;
+    };
+
+    namespace detail {
+        inline std::atomic<std::uint64_t> rejected_connections{0};
+        inline std::atomic<std::uint64_t> rejected_requests{0};
+
+        inline token_buckets &connections() {
+            static token_buckets buckets{RATE_LIMIT_CONNECTIONS, RATE_LIMIT_CONNECTIONS_BURST};
+            return buckets;
+        }
+
+        inline token_buckets &requests() {
+            static token_buckets buckets{RATE_LIMIT_REQUESTS, RATE_LIMIT_REQUESTS_BURST};
+            return buckets;
+        }
+
+        inline canned_response make_too_many(unsigned retry_after) {
+            Response res;
+            res.result(http::status::too_many_requests);
+            res.set(http::field::content_type, "text/plain");
+            res.set(http::field::retry_after, std::to_string(retry_after));
+            res.body() = "429 Too Many Requests";
+            return canned_response{res};
+        }
+    }
+
+    /// @brief Whether either limit is compiled in.
+    inline constexpr bool enabled = RATE_LIMIT_CONNECTIONS > 0 || RATE_LIMIT_REQUESTS > 0;
+
+    /// @brief Admit a new connection from @p ip under `RATE_LIMIT_CONNECTIONS`.
+    inline bool admit_connection(const boost::asio::ip::address &ip) {
+        if constexpr (RATE_LIMIT_CONNECTIONS <= 0) {
+            return true;
+        } else {
+            if (detail::connections().acquire(client_key{ip})) return true;
+            detail::rejected_connections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    /**
+     * @brief Admit a request from @p ip to the route with metrics id @p route under `RATE_LIMIT_REQUESTS`.
+     * @return nullptr if admitted, otherwise the `429` to answer with.
+     */
+    inline const canned_response *admit_request(const boost::asio::ip::address &ip, [[maybe_unused]] std::uint32_t route) {
+        if constexpr (RATE_LIMIT_REQUESTS <= 0) {
+            return nullptr;
+        } else {
+#ifdef RATE_LIMIT_PER_ROUTE
+            const client_key key{ip, route};
+#else
+            const client_key key{ip};
+#endif
+            if (detail::requests().acquire(key)) return nullptr;
+            detail::rejected_requests.fetch_add(1, std::memory_order_relaxed);
+            static const canned_response too_many = detail::make_too_many(detail::requests().retry_after());
+            return &too_many;
+        }
+    }
+
+    /// @brief Bytes sent to a connection refused under `RATE_LIMIT_CONNECTIONS` before closing it.
+    inline std::string_view connection_refusal() {
+        static const std::string refusal = [] {
+            const canned_response too_many = detail::make_too_many(std::max(1u, detail::connections().retry_after()));
+            std::string bytes;
+            for (const auto &part: too_many.wire(false, 11, false)) {
+                bytes.append(static_cast<const char *>(part.data()), part.size());
+            }
+            return bytes;
+        }();
+        return refusal;
+    }
+
+    /// @brief Connections refused under `RATE_LIMIT_CONNECTIONS`.
+    [[maybe_unused]] inline std::uint64_t rejected_connections() {
+        return detail::rejected_connections.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Requests refused under `RATE_LIMIT_REQUESTS`.
+    [[maybe_unused]] inline std::uint64_t rejected_requests() {
+        return detail::rejected_requests.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,417 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "marcos.hpp"
+#include "bulgogi.hpp"
+#include "canned_response.hpp"
+#include "route_table.hpp"
+
+
+namespace bulgogi {
+
+    /**
+     * @brief How the responses of a route are cached, attached with `REGISTER_CACHE`.
+     *
+     * Example:
+     * @code
+     * inline const bulgogi::cache_policy catalog_cache{std::chrono::seconds(300), {"Accept-Language"}};
+     * REGISTER_CACHE(catalog_cache, "api/catalog", "api/item/{id:int}");
+     * @endcode
+     */
+    struct cache_policy {
+        /// @brief Lifetime of a response whose `Cache-Control` sets no `max-age`; 0 caches only
+        ///        responses that do.
+        std::chrono::seconds ttl{0};
+        /// @brief Request headers whose values are part of the key, besides path and query.
+        std::vector<std::string> vary;
+
+        [[nodiscard]] bool varies_on(std::string_view header) const noexcept {
+            return std::any_of(vary.begin(), vary.end(),
+                               [header](const std::string &h) { return beast::iequals(h, header); });
+        }
+    };
+}
+
+
+/**
+ * @brief Process-wide cache of serialised responses for `REGISTER_CACHE` routes.
+ *
+ * A `GET` or `HEAD` to a cached route is looked up before its handler runs; a hit is written
+ * straight from the stored `canned_response`, with no handler call, serialisation or compression,
+ * plus an `Age` header with the seconds since it was stored, so clients count the response's
+ * `max-age` from then. On a miss the handler's response to a `GET` is stored if it allows it.
+ *
+ * - Keys are the request path, its query parameters sorted by name, the `Origin` header (CORS
+ *   headers depend on it), the values of the policy's `vary` headers and, with
+ *   `ENABLE_COMPRESSION`, the negotiated content coding.
+ * - Entries live for `s-maxage` or `max-age` from the response's `Cache-Control`, else for the
+ *   policy's `ttl`. Responses with `no-store`, `no-cache`, `private`, `Set-Cookie`, a `Vary` on a
+ *   header outside the key, a streamed body or an uncacheable status are not stored.
+ * - Requests carrying `If-None-Match`/`If-Modified-Since`, or `Authorization` or `Cookie` without
+ *   the policy varying on that header, bypass the cache: their answers may be per user.
+ * - The cache is split into `shard_count` LRUs by path hash, each with its own mutex and an equal
+ *   part of `RESPONSE_CACHE_SIZE` bytes; responses over `RESPONSE_CACHE_ENTRY_MAX` are not kept.
+ *   Expired entries are dropped when looked up or when the LRU needs room.
+ * - `invalidate()`, `invalidate_prefix()` and `clear()` may be called from any handler, e.g. a
+ *   `POST` that changes what a cached `GET` returns.
+ */
+namespace bulgogi::response_cache {
+
+    using clock = std::chrono::steady_clock;
+
+    /// @brief Bytes of responses kept over all shards; 0 disables the cache.
+    inline constexpr std::size_t capacity = RESPONSE_CACHE_SIZE;
+
+    /// @brief Largest single response kept (bytes).
+    inline constexpr std::size_t entry_max = RESPONSE_CACHE_ENTRY_MAX;
+
+    inline constexpr std::size_t shard_count = 16;
+
+    /// @brief A cache hit kept alive while it is written, with its `Age` header line.
+    struct pinned_response {
+        std::shared_ptr<const canned_response> response;
+        std::string age_line;  // "Age: N\r\n", short enough to stay in the string's own buffer
+
+        /// @brief The `Age` value alone, for transports that frame headers themselves.
+        [[nodiscard]] std::string_view age() const noexcept {
+            const std::string_view line = age_line;
+            return line.size() > 7 ? line.substr(5, line.size() - 7) : std::string_view();
+        }
+    };
+
+    namespace detail {
+        inline std::atomic<std::uint64_t> hits{0};
+        inline std::atomic<std::uint64_t> misses{0};
+        inline std::atomic<std::uint64_t> stores{0};
+        inline std::atomic<std::uint64_t> evictions{0};
+
+        /// @brief Keeps the entry written by the current request alive until the write completes.
+        inline pinned_response &pinned_slot() {
+            thread_local pinned_response slot;
+            return slot;
+        }
+
+        /// @brief One LRU of the cache; entries of a path always land in the same shard.
+        class shard {
+            struct entry {
+                std::string key;
+                std::shared_ptr<const canned_response> response;
+                clock::time_point stored;
+                clock::time_point expires;
+                std::size_t bytes;
+            };
+
+            std::mutex mutex_;
+            std::list<entry> lru_;  // most recently used first
+            std::unordered_map<std::string_view, std::list<entry>::iterator> index_;
+            std::size_t bytes_ = 0;
+
+            void erase(std::list<entry>::iterator it) {
+                bytes_ -= it->bytes;
+                index_.erase(it->key);
+                lru_.erase(it);
+            }
+
+        public:
+            static constexpr std::size_t capacity = response_cache::capacity / shard_count;
+
+            /// @return The live entry for @p key and when it was stored, or a null response.
+            [[nodiscard]] std::pair<std::shared_ptr<const canned_response>, clock::time_point>
+            find(std::string_view key, clock::time_point now) {
+                std::lock_guard lock(mutex_);
+                const auto it = index_.find(key);
+                if (it == index_.end()) return {};
+                if (it->second->expires <= now) {
+                    erase(it->second);
+                    return {};
+                }
+                lru_.splice(lru_.begin(), lru_, it->second);
+                return {it->second->response, it->second->stored};
+            }
+
+            /// @return false if the entry alone is larger than the shard.
+            bool insert(std::string &&key, std::shared_ptr<const canned_response> response, clock::time_point now,
+                        clock::time_point expires) {
+                const std::size_t bytes = response->footprint() + key.size() + sizeof(entry);
+                if (bytes > capacity) return false;
+                std::lock_guard lock(mutex_);
+                if (const auto it = index_.find(key); it != index_.end()) erase(it->second);
+                while (!lru_.empty() && bytes_ + bytes > capacity) {
+                    erase(std::prev(lru_.end()));
+                    evictions.fetch_add(1, std::memory_order_relaxed);
+                }
+                bytes_ += bytes;
+                lru_.push_front(entry{std::move(key), std::move(response), now, expires, bytes});
+                index_.emplace(lru_.front().key, lru_.begin());
+                return true;
+            }
+
+            /// @brief Drop the entries whose path (the key up to `?`) satisfies @p match.
+            template<typename Match>
+            std::size_t erase_paths(Match &&match) {
+                std::lock_guard lock(mutex_);
+                std::size_t erased = 0;
+                for (auto it = lru_.begin(); it != lru_.end();) {
+                    const auto next = std::next(it);
+                    if (match(std::string_view(it->key).substr(0, it->key.find('?')))) {
+                        erase(it);
+                        ++erased;
+                    }
+                    it = next;
+                }
+                return erased;
+            }
+
+            [[nodiscard]] std::pair<std::size_t, std::size_t> usage() {
+                std::lock_guard lock(mutex_);
+                return {lru_.size(), bytes_};
+            }
+        };
+
+        inline std::array<shard, shard_count> &shards() {
+            static std::array<shard, shard_count> instance;
+            return instance;
+        }
+
+        inline shard &shard_of(std::string_view path) {
+            return shards()[std::hash<std::string_view>{}(path) % shard_count];
+        }
+
+        /// @brief Seconds given by `name=N` in a `Cache-Control` value, or -1 if absent.
+        inline long directive(std::string_view cache_control, std::string_view name) {
+            for (std::size_t at = 0; (at = cache_control.find(name, at)) != std::string_view::npos; at += name.size()) {
+                const bool starts = at == 0 || cache_control[at - 1] == ',' || cache_control[at - 1] == ' ';
+                const std::size_t eq = at + name.size();
+                if (!starts || eq >= cache_control.size() || cache_control[eq] != '=') continue;
+                long seconds = -1;
+                std::from_chars(cache_control.data() + eq + 1, cache_control.data() + cache_control.size(), seconds);
+                return seconds;
+            }
+            return -1;
+        }
+
+        inline bool has_token(std::string_view list, std::string_view token) {
+            for (std::size_t at = 0; at < list.size();) {
+                std::size_t end = list.find(',', at);
+                if (end == std::string_view::npos) end = list.size();
+                std::string_view item = list.substr(at, end - at);
+                while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+                item = item.substr(0, item.find_first_of(" ="));
+                if (beast::iequals(item, token)) return true;
+                at = end + 1;
+            }
+            return false;
+        }
+
+        /// @brief Whether every header named in the response's `Vary` is part of the key.
+        inline bool vary_covered(std::string_view vary, const cache_policy &policy) {
+            for (std::size_t at = 0; at < vary.size();) {
+                std::size_t end = vary.find(',', at);
+                if (end == std::string_view::npos) end = vary.size();
+                std::string_view name = vary.substr(at, end - at);
+                while (!name.empty() && name.front() == ' ') name.remove_prefix(1);
+                while (!name.empty() && name.back() == ' ') name.remove_suffix(1);
+                if (name == "*") return false;
+                if (name.empty() || beast::iequals(name, "origin") || policy.varies_on(name)) {
+                    at = end + 1;
+                    continue;
+                }
+#ifdef ENABLE_COMPRESSION
+                if (beast::iequals(name, "accept-encoding")) {  // the negotiated coding is in the key
+                    at = end + 1;
+                    continue;
+                }
+#endif
+                return false;
+            }
+            return true;
+        }
+    }
+
+    /// @brief Whether @p req may be answered from, or its response stored in, the cache.
+    [[nodiscard]] inline bool cacheable(const Request &req, const cache_policy &policy) {
+        if constexpr (capacity == 0) {
+            return false;
+        } else {
+            if (req.method() != http::verb::get && req.method() != http::verb::head) return false;
+            // Conditional requests are left to the handler, which knows the validators
+            if (req.find(http::field::if_none_match) != req.end() ||
+                req.find(http::field::if_modified_since) != req.end()) return false;
+            // Credentials outside the key would let one user's answer reach another
+            if (req.find(http::field::authorization) != req.end() && !policy.varies_on("authorization")) return false;
+            return req.find(http::field::cookie) == req.end() || policy.varies_on("cookie");
+        }
+    }
+
+    /**
+     * @brief Cache key of @p req: path, query parameters sorted by name (pairs with the same name
+     *        keep their order), `Origin`, the policy's `vary` headers and @p coding.
+     */
+    [[nodiscard]] inline std::string key_of(const Request &req, const cache_policy &policy, std::string_view coding = {}) {
+        const std::string_view target = req.target();
+        const std::size_t question = target.find('?');
+        std::string key(route_of(target));
+        key.push_back('?');
+
+        if (question != std::string_view::npos) {
+            std::vector<std::string_view> params;
+            const std::string_view query = target.substr(question + 1);
+            for (std::size_t at = 0; at <= query.size();) {
+                std::size_t end = query.find('&', at);
+                if (end == std::string_view::npos) end = query.size();
+                if (end > at) params.push_back(query.substr(at, end - at));
+                at = end + 1;
+            }
+            std::stable_sort(params.begin(), params.end(), [](std::string_view a, std::string_view b) {
+                return a.substr(0, a.find('=')) < b.substr(0, b.find('='));
+            });
+            for (std::size_t i = 0; i < params.size(); ++i) {
+                if (i) key.push_back('&');
+                key.append(params[i]);
+            }
+        }
+
+        // Values are separated by '\n', which cannot occur in a header value
+        key.push_back('\n');
+        key.append(req[http::field::origin]);
+        for (const auto &header: policy.vary) key.append("\n").append(req[header]);
+        key.push_back('\n');
+        key.append(coding);
+        return key;
+    }
+
+    /**
+     * @brief Look @p key up.
+     * @return The stored response, pinned with its `Age` line until `take_pinned()` or the next
+     *         lookup on this thread, or `nullptr`.
+     */
+    [[nodiscard]] inline const canned_response *lookup(std::string_view key) {
+        const std::string_view path = key.substr(0, key.find('?'));
+        const auto now = clock::now();
+        auto [hit, stored] = detail::shard_of(path).find(key, now);
+        if (!hit) {
+            detail::misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        detail::hits.fetch_add(1, std::memory_order_relaxed);
+        auto &pinned = detail::pinned_slot();
+        pinned.response = std::move(hit);
+        pinned.age_line = "Age: ";
+        pinned.age_line += std::to_string(std::chrono::duration_cast<std::chrono::seconds>(now - stored).count());
+        pinned.age_line += "\r\n";
+        return pinned.response.get();
+    }
+
+    /**
+     * @brief How long @p res may be kept under @p policy.
+     * @return Zero if it must not be stored.
+     */
+    [[nodiscard]] inline std::chrono::seconds lifetime(const Response &res, const cache_policy &policy) {
+        switch (res.result_int()) {
+            case 200: case 203: case 204: case 300: case 301: case 308: case 404: case 410:
+                break;
+            default:
+                return std::chrono::seconds(0);
+        }
+        if (res.find(http::field::set_cookie) != res.end()) return std::chrono::seconds(0);
+        if (const auto vary = res.find(http::field::vary); vary != res.end() && !detail::vary_covered(vary->value(), policy)) {
+            return std::chrono::seconds(0);
+        }
+
+        const std::string_view cc = res[http::field::cache_control];
+        if (detail::has_token(cc, "no-store") || detail::has_token(cc, "no-cache") || detail::has_token(cc, "private")) {
+            return std::chrono::seconds(0);
+        }
+        long seconds = detail::directive(cc, "s-maxage");
+        if (seconds < 0) seconds = detail::directive(cc, "max-age");
+        return seconds >= 0 ? std::chrono::seconds(seconds) : policy.ttl;
+    }
+
+    /// @brief Keep @p res under @p key if `lifetime()` allows it.
+    inline void store(std::string &&key, const Response &res, const cache_policy &policy) {
+        const auto ttl = lifetime(res, policy);
+        if (ttl.count() <= 0 || res.body().size() > entry_max) return;
+        auto response = std::make_shared<const canned_response>(res);
+        const std::string_view path = std::string_view(key).substr(0, key.find('?'));
+        const auto now = clock::now();
+        if (detail::shard_of(path).insert(std::move(key), std::move(response), now, now + ttl)) {
+            detail::stores.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief Take over the response pinned by the last `lookup()` on this thread (empty if none).
+    [[nodiscard]] inline pinned_response take_pinned() noexcept {
+        return std::exchange(detail::pinned_slot(), pinned_response{});
+    }
+
+    /**
+     * @brief Drop every cached response for @p path (all queries and variants).
+     * @param path Request path with or without the leading `/`, e.g. `"api/item/42"`.
+     * @return Number of entries dropped.
+     */
+    inline std::size_t invalidate(std::string_view path) {
+        std::string normalized;
+        if (!path.starts_with('/')) {
+            normalized.reserve(path.size() + 1);
+            normalized.append("/").append(path);
+            path = normalized;
+        }
+        return detail::shard_of(path).erase_paths([path](std::string_view p) { return p == path; });
+    }
+
+    /// @brief Drop every cached response whose path starts with @p prefix (leading `/` optional).
+    inline std::size_t invalidate_prefix(std::string_view prefix) {
+        if (prefix.starts_with('/')) prefix.remove_prefix(1);
+        std::size_t erased = 0;
+        for (auto &shard: detail::shards()) {
+            erased += shard.erase_paths([prefix](std::string_view p) { return p.substr(1).starts_with(prefix); });
+        }
+        return erased;
+    }
+
+    /// @brief Drop everything.
+    inline std::size_t clear() {
+        return invalidate_prefix("");
+    }
+
+    /// @brief Lookups answered from the cache.
+    [[maybe_unused]] inline std::uint64_t hits() { return detail::hits.load(std::memory_order_relaxed); }
+
+    /// @brief Lookups that ran the handler.
+    [[maybe_unused]] inline std::uint64_t misses() { return detail::misses.load(std::memory_order_relaxed); }
+
+    /// @brief Responses stored.
+    [[maybe_unused]] inline std::uint64_t stores() { return detail::stores.load(std::memory_order_relaxed); }
+
+    /// @brief Entries evicted to make room (expired or not).
+    [[maybe_unused]] inline std::uint64_t evictions() { return detail::evictions.load(std::memory_order_relaxed); }
+
+    /// @brief Entries currently stored and the bytes they hold.
+    [[maybe_unused]] inline std::pair<std::size_t, std::size_t> usage() {
+        std::pair<std::size_t, std::size_t> total{0, 0};
+        for (auto &shard: detail::shards()) {
+            const auto [entries, bytes] = shard.usage();
+            total.first += entries;
+            total.second += bytes;
+        }
+        return total;
+    }
+}
@@ -0,0 +1,142 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+namespace bulgogi {
+
+    /**
+     * @brief Path part of a request target, i.e. everything before the first `?`.
+     * @param target Raw request target such as `/api/user?id=1`.
+     * @return View into @p target; no allocation is made.
+     */
+    inline std::string_view route_of(std::string_view target) noexcept {
+        const auto query_pos = target.find('?');
+        return query_pos == std::string_view::npos ? target : target.substr(0, query_pos);
+    }
+
+    /**
+     * @brief Immutable path → value index, built once after static registration.
+     *
+     * Routes never change after `views::function_map` is filled by the registrars, so the server
+     * freezes them into a flat open-addressing table instead of querying a
+     * `std::unordered_map<std::string, ...>`:
+     * - All paths are stored back to back in a single string; slots keep offset, length and the
+     *   precomputed hash, so a probe touches one cache line and compares bytes only on a full
+     *   hash match.
+     * - The table is sized to a power of two with a load factor of at most 1/2, which keeps linear
+     *   probe sequences short.
+     * - `find()` takes a `std::string_view` (typically into `req.target()`) and never allocates.
+     *
+     * @tparam Value Payload stored per route (e.g. `views::HandlerFunc`).
+     */
+    template<typename Value>
+    class route_table {
+        struct slot {
+            std::size_t hash = 0;
+            std::uint32_t offset = 0;
+            std::uint32_t length = empty;
+            Value value{};
+
+            static constexpr std::uint32_t empty = std::numeric_limits<std::uint32_t>::max();
+        };
+
+        std::string keys_;
+        std::vector<slot> slots_;
+        std::size_t mask_ = 0;
+        std::size_t size_ = 0;
+
+        static std::size_t hash_of(std::string_view path) noexcept {
+            return std::hash<std::string_view>{}(path);
+        }
+
+        [[nodiscard]] std::string_view key_of(const slot &s) const noexcept {
+            return {keys_.data() + s.offset, s.length};
+        }
+
+    public:
+        route_table() = default;
+
+        /**
+         * @brief Freeze a set of routes.
+         * @param entries Path/value pairs; for duplicate paths the last one wins, as with
+         *                assignment into `function_map`.
+         */
+        explicit route_table(const std::vector<std::pair<std::string, Value>> &entries) {
+            std::size_t total = 0;
+            for (const auto &[path, _]: entries) total += path.size();
+            if (total >= slot::empty) throw std::length_error("route_table: paths too long");
+            keys_.reserve(total);
+
+            slots_.resize(std::bit_ceil(std::max<std::size_t>(entries.size() * 2, 8)));
+            mask_ = slots_.size() - 1;
+
+            for (const auto &[path, value]: entries) {
+                const std::size_t h = hash_of(path);
+                for (std::size_t i = h & mask_;; i = (i + 1) & mask_) {
+                    slot &s = slots_[i];
+                    if (s.length == slot::empty) {
+                        s.hash = h;
+                        s.offset = static_cast<std::uint32_t>(keys_.size());
+                        s.length = static_cast<std::uint32_t>(path.size());
+                        s.value = value;
+                        keys_ += path;
+                        ++size_;
+                        break;
+                    }
+                    if (s.hash == h && key_of(s) == path) {
+                        s.value = value;
+                        break;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Look up an exact path.
+         * @param path Path without query string, e.g. `route_of(req.target())`.
+         * @return Pointer to the stored value, or `nullptr` if the path is not registered.
+         */
+        [[nodiscard]] const Value *find(std::string_view path) const noexcept {
+            if (size_ == 0) return nullptr;
+            const std::size_t h = hash_of(path);
+            for (std::size_t i = h & mask_;; i = (i + 1) & mask_) {
+                const slot &s = slots_[i];
+                if (s.length == slot::empty) return nullptr;
+                if (s.hash == h && s.length == path.size() &&
+                    std::memcmp(keys_.data() + s.offset, path.data(), path.size()) == 0) {
+                    return &s.value;
+                }
+            }
+        }
+
+        [[nodiscard]] bool contains(std::string_view path) const noexcept {
+            return find(path) != nullptr;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return size_;
+        }
+
+        /// @brief Visit every registered path and value, in table order.
+        template<typename F>
+        void for_each(F &&f) const {
+            for (const auto &s: slots_) {
+                if (s.length != slot::empty) f(key_of(s), s.value);
+            }
+        }
+    };
+}
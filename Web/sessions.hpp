@@ -0,0 +1,75 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "marcos.hpp"
+
+
+/**
+ * @brief Process-wide accounting of in-flight HTTP sessions.
+ *
+ * The server reserves a slot before it starts serving an accepted connection and releases it
+ * when the session object is destroyed, so `active()` is the number of connections currently
+ * being served and `peak()` the high-water mark since start-up.
+ *
+ * At most `MAX_SESSIONS` slots can be held at once. What happens to extra connections is chosen
+ * at compile time: by default the server stops accepting (they queue in the kernel backlog) and
+ * resumes as soon as a slot is freed; with `REJECT_OVERFLOW` they are answered with a
+ * preformatted `503` and closed, which is counted in `rejected()`.
+ */
+namespace bulgogi::sessions {
+
+    /// @brief Maximum number of sessions served concurrently.
+    inline constexpr std::size_t limit = MAX_SESSIONS;
+
+    namespace detail {
+        inline std::atomic<std::size_t> active{0};
+        inline std::atomic<std::size_t> peak{0};
+        inline std::atomic<std::uint64_t> rejected{0};
+    }
+
+    /**
+     * @brief Reserve a session slot.
+     * @return true if a slot was taken; false if `limit` sessions are already in flight.
+     */
+    inline bool try_acquire() {
+        std::size_t cur = detail::active.load(std::memory_order_relaxed);
+        do {
+            if (cur >= limit) return false;
+        } while (!detail::active.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel));
+
+        std::size_t seen = detail::peak.load(std::memory_order_relaxed);
+        while (seen < cur + 1 &&
+               !detail::peak.compare_exchange_weak(seen, cur + 1, std::memory_order_relaxed)) {}
+        return true;
+    }
+
+    /// @brief Give back a slot taken by `try_acquire()`.
+    inline void release() {
+        detail::active.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    /// @brief Record a connection that was turned away because the server was full.
+    inline void count_rejected() {
+        detail::rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// @brief Number of sessions currently being served.
+    [[maybe_unused]] inline std::size_t active() {
+        return detail::active.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Highest number of concurrent sessions observed since start-up.
+    [[maybe_unused]] inline std::size_t peak() {
+        return detail::peak.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Connections rejected with `503` while at the limit (`REJECT_OVERFLOW` only).
+    [[maybe_unused]] inline std::uint64_t rejected() {
+        return detail::rejected.load(std::memory_order_relaxed);
+    }
+}
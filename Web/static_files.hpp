@@ -0,0 +1,511 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include "bulgogi.hpp"
+#include "marcos.hpp"
+
+/// @brief 1 when the server can hand file bodies to the kernel with `sendfile(2)`.
+#if defined(__linux__)
+#define BULGOGI_SENDFILE 1
+#else
+#define BULGOGI_SENDFILE 0
+#endif
+
+
+namespace bulgogi {
+
+    namespace detail {
+
+        /// @brief Owning POSIX file descriptor.
+        class unique_fd {
+            int fd_ = -1;
+
+        public:
+            unique_fd() = default;
+
+            explicit unique_fd(int fd) noexcept : fd_(fd) {}
+
+            unique_fd(unique_fd &&other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+
+            unique_fd &operator=(unique_fd &&other) noexcept {
+                if (this != &other) {
+                    reset();
+                    fd_ = std::exchange(other.fd_, -1);
+                }
+                return *this;
+            }
+
+            ~unique_fd() { reset(); }
+
+            void reset() noexcept {
+                if (fd_ >= 0) ::close(fd_);
+                fd_ = -1;
+            }
+
+            [[nodiscard]] int get() const noexcept { return fd_; }
+
+            explicit operator bool() const noexcept { return fd_ >= 0; }
+        };
+
+        /// @brief File body the session sends with `sendfile(2)` after writing the headers.
+        struct pending_file {
+            unique_fd fd;
+            std::uint64_t offset = 0;
+            std::uint64_t length = 0;
+        };
+
+        /// @brief Hand-off from `static_files::serve` to the session that called it (same thread).
+        inline std::optional<pending_file> &file_slot() {
+            thread_local std::optional<pending_file> slot;
+            return slot;
+        }
+
+        /// @brief Read @p file with `pread` as a `set_stream` producer, where `sendfile(2)` cannot be used.
+        inline stream_producer file_producer(pending_file &&file) {
+            auto source = std::make_shared<pending_file>(std::move(file));
+            return [source](char *buffer, std::size_t capacity) -> std::size_t {
+                if (source->length == 0) return 0;
+                const auto n = ::pread(source->fd.get(), buffer, std::min<std::uint64_t>(capacity, source->length),
+                                       static_cast<off_t>(source->offset));
+                if (n <= 0) throw std::runtime_error("static file truncated while sending");
+                source->offset += n;
+                source->length -= n;
+                return static_cast<std::size_t>(n);
+            };
+        }
+
+        inline std::int64_t mtime_ns(const struct stat &st) noexcept {
+#if defined(__APPLE__)
+            return std::int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+            return std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+        }
+
+        /// @brief Content type by file extension; unknown extensions are served as octet-stream.
+        inline std::string_view mime_type(std::string_view path) noexcept {
+            static constexpr std::pair<std::string_view, std::string_view> types[] = {
+                    {"html",  "text/html; charset=utf-8"},
+                    {"htm",   "text/html; charset=utf-8"},
+                    {"css",   "text/css; charset=utf-8"},
+                    {"js",    "text/javascript; charset=utf-8"},
+                    {"mjs",   "text/javascript; charset=utf-8"},
+                    {"json",  "application/json"},
+                    {"map",   "application/json"},
+                    {"txt",   "text/plain; charset=utf-8"},
+                    {"csv",   "text/csv; charset=utf-8"},
+                    {"xml",   "application/xml"},
+                    {"svg",   "image/svg+xml"},
+                    {"png",   "image/png"},
+                    {"jpg",   "image/jpeg"},
+                    {"jpeg",  "image/jpeg"},
+                    {"gif",   "image/gif"},
+                    {"webp",  "image/webp"},
+                    {"avif",  "image/avif"},
+                    {"ico",   "image/vnd.microsoft.icon"},
+                    {"woff",  "font/woff"},
+                    {"woff2", "font/woff2"},
+                    {"ttf",   "font/ttf"},
+                    {"wasm",  "application/wasm"},
+                    {"pdf",   "application/pdf"},
+                    {"mp4",   "video/mp4"},
+                    {"webm",  "video/webm"},
+                    {"mp3",   "audio/mpeg"},
+            };
+            const auto dot = path.rfind('.');
+            if (dot == std::string_view::npos || path.find('/', dot) != std::string_view::npos) {
+                return "application/octet-stream";
+            }
+            const std::string_view ext = path.substr(dot + 1);
+            for (const auto &[e, type]: types) {
+                if (ext.size() == e.size() && std::equal(ext.begin(), ext.end(), e.begin(), [](char a, char b) {
+                    return (a | 0x20) == b;
+                })) return type;
+            }
+            return "application/octet-stream";
+        }
+
+        inline constexpr std::string_view week_days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        inline constexpr std::string_view months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                                      "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+        /// @brief Format @p t as an IMF-fixdate (`Sun, 06 Nov 1994 08:49:37 GMT`), independent of locale.
+        inline std::string http_date(std::time_t t) {
+            std::tm tm{};
+            gmtime_r(&t, &tm);
+            char buf[32];
+            const int n = std::snprintf(buf, sizeof(buf), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                                        week_days[tm.tm_wday].data(), tm.tm_mday, months[tm.tm_mon].data(),
+                                        tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec);
+            return {buf, static_cast<std::size_t>(n)};
+        }
+
+        /// @brief Parse an IMF-fixdate; the obsolete RFC 850 and asctime forms are not accepted.
+        inline std::optional<std::time_t> parse_http_date(std::string_view s) noexcept {
+            if (s.size() != 29 || s.substr(3, 2) != ", " || s.substr(25) != " GMT") return std::nullopt;
+            const auto num = [&](std::size_t pos, std::size_t len) -> int {
+                int v = 0;
+                for (std::size_t i = pos; i < pos + len; ++i) {
+                    if (s[i] < '0' || s[i] > '9') return -1;
+                    v = v * 10 + (s[i] - '0');
+                }
+                return v;
+            };
+            std::tm tm{};
+            tm.tm_mday = num(5, 2);
+            tm.tm_year = num(12, 4) - 1900;
+            tm.tm_hour = num(17, 2);
+            tm.tm_min = num(20, 2);
+            tm.tm_sec = num(23, 2);
+            tm.tm_mon = -1;
+            for (int m = 0; m < 12; ++m) {
+                if (s.substr(8, 3) == months[m]) tm.tm_mon = m;
+            }
+            if (tm.tm_mday < 0 || tm.tm_year < 0 || tm.tm_hour < 0 || tm.tm_min < 0 || tm.tm_sec < 0 || tm.tm_mon < 0) {
+                return std::nullopt;
+            }
+            return timegm(&tm);
+        }
+
+        /// @brief `If-None-Match` / `If-Range` comparison: `*` or any listed tag, weak prefixes ignored.
+        inline bool etag_matches(std::string_view header, std::string_view etag) noexcept {
+            while (!header.empty()) {
+                const auto comma = header.find(',');
+                std::string_view tag = header.substr(0, comma);
+                header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+                while (!tag.empty() && tag.front() == ' ') tag.remove_prefix(1);
+                while (!tag.empty() && tag.back() == ' ') tag.remove_suffix(1);
+                if (tag.starts_with("W/")) tag.remove_prefix(2);
+                if (tag == "*" || tag == etag) return true;
+            }
+            return false;
+        }
+
+        enum class range_result { none, satisfiable, unsatisfiable };
+
+        /**
+         * @brief Parse a single `bytes=` range against a representation of @p size bytes.
+         *
+         * Multi-range requests and other units yield `none`, which serves the whole file: that is
+         * always a valid answer to a `Range` request.
+         */
+        inline range_result parse_range(std::string_view header, std::uint64_t size,
+                                        std::uint64_t &first, std::uint64_t &last) noexcept {
+            if (!header.starts_with("bytes=")) return range_result::none;
+            header.remove_prefix(6);
+            if (header.find(',') != std::string_view::npos) return range_result::none;
+
+            const auto dash = header.find('-');
+            if (dash == std::string_view::npos) return range_result::none;
+            const std::string_view a = header.substr(0, dash);
+            const std::string_view b = header.substr(dash + 1);
+            const auto parse = [](std::string_view v, std::uint64_t &out) {
+                const auto [ptr, ec] = std::from_chars(v.data(), v.data() + v.size(), out);
+                return !v.empty() && ec == std::errc{} && ptr == v.data() + v.size();
+            };
+
+            std::uint64_t x = 0, y = 0;
+            if (a.empty()) {  // suffix range: the last y bytes
+                if (!parse(b, y)) return range_result::none;
+                if (y == 0 || size == 0) return range_result::unsatisfiable;
+                first = size - std::min(y, size);
+                last = size - 1;
+                return range_result::satisfiable;
+            }
+            if (!parse(a, x)) return range_result::none;
+            if (b.empty()) y = size ? size - 1 : 0;
+            else if (!parse(b, y) || y < x) return range_result::none;
+            if (x >= size) return range_result::unsatisfiable;
+            first = x;
+            last = std::min(y, size - 1);
+            return range_result::satisfiable;
+        }
+
+        /**
+         * @brief Percent-decode a URL path below a static mount and check it stays inside it.
+         *
+         * Empty, `.` and `..` segments, segments starting with `.` (dotfiles such as `.git` or
+         * `.env`), backslashes and NUL bytes are rejected.
+         */
+        inline bool safe_relative_path(std::string_view raw, std::string &out) {
+            out.clear();
+            out.reserve(raw.size());
+            for (std::size_t i = 0; i < raw.size(); ++i) {
+                char c = raw[i];
+                if (c == '%' && i + 2 < raw.size() && hex_value(raw[i + 1]) >= 0 && hex_value(raw[i + 2]) >= 0) {
+                    c = static_cast<char>(hex_value(raw[i + 1]) * 16 + hex_value(raw[i + 2]));
+                    i += 2;
+                }
+                if (c == '\0' || c == '\\') return false;
+                out.push_back(c);
+            }
+
+            std::string_view rest = out;
+            while (!rest.empty()) {
+                const auto slash = rest.find('/');
+                const std::string_view seg = rest.substr(0, slash);
+                if (seg.empty() && slash != std::string_view::npos) return false;
+                if (!seg.empty() && seg.front() == '.') return false;
+                rest = slash == std::string_view::npos ? std::string_view{} : rest.substr(slash + 1);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Byte-bounded LRU of small file contents, shared by every static mount.
+         *
+         * Entries are keyed by file path and validated against size and modification time on
+         * every hit, so an edited file is reloaded on the next request.
+         */
+        class file_cache {
+            struct entry {
+                std::string path;
+                std::int64_t mtime;
+                std::shared_ptr<const std::string> body;
+            };
+
+            std::mutex mutex_;
+            std::list<entry> lru_;  // most recently used first
+            std::unordered_map<std::string_view, std::list<entry>::iterator> index_;
+            std::size_t bytes_ = 0;
+            std::size_t capacity_;
+
+            void erase(std::list<entry>::iterator it) {
+                bytes_ -= it->body->size();
+                index_.erase(it->path);
+                lru_.erase(it);
+            }
+
+        public:
+            explicit file_cache(std::size_t capacity) : capacity_(capacity) {}
+
+            [[nodiscard]] std::shared_ptr<const std::string> find(const std::string &path, std::int64_t mtime,
+                                                                  std::uint64_t size) {
+                std::lock_guard lock(mutex_);
+                const auto it = index_.find(path);
+                if (it == index_.end()) return nullptr;
+                if (it->second->mtime != mtime || it->second->body->size() != size) {
+                    erase(it->second);
+                    return nullptr;
+                }
+                lru_.splice(lru_.begin(), lru_, it->second);
+                return it->second->body;
+            }
+
+            void insert(const std::string &path, std::int64_t mtime, std::shared_ptr<const std::string> body) {
+                if (body->size() > capacity_) return;
+                std::lock_guard lock(mutex_);
+                if (const auto it = index_.find(path); it != index_.end()) erase(it->second);
+                while (!lru_.empty() && bytes_ + body->size() > capacity_) erase(std::prev(lru_.end()));
+
+                bytes_ += body->size();
+                lru_.push_front(entry{path, mtime, std::move(body)});
+                index_.emplace(lru_.front().path, lru_.begin());
+            }
+        };
+
+        inline file_cache &static_cache() {
+            static file_cache cache(STATIC_CACHE_SIZE);
+            return cache;
+        }
+
+        /// @brief Read exactly @p size bytes of @p path, or nothing if the file changed meanwhile.
+        inline std::shared_ptr<const std::string> read_file(const std::string &path, std::uint64_t size) {
+            unique_fd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+            if (!fd) return nullptr;
+            auto body = std::make_shared<std::string>(size, '\0');
+            std::size_t done = 0;
+            while (done < size) {
+                const auto n = ::read(fd.get(), body->data() + done, size - done);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return nullptr;
+                done += static_cast<std::size_t>(n);
+            }
+            return body;
+        }
+    }
+
+    /**
+     * @brief Serve the files below one directory, registered with `REGISTER_STATIC(...)`.
+     *
+     * Only `GET` and `HEAD` are accepted (`OPTIONS` and CORS go through `check_method`).
+     * For every request:
+     * - the URL path is decoded and confined to the root (see `detail::safe_relative_path`);
+     *   a directory maps to its `index.html`;
+     * - `ETag` (modification time and size) and `Last-Modified` are sent, and `If-None-Match` /
+     *   `If-Modified-Since` are answered with `304 Not Modified`;
+     * - a single `Range` (honouring `If-Range`) is answered with `206`, an unsatisfiable one with `416`;
+     * - without `Range`, a precompressed `<file>.br` or `<file>.gz` next to the file is sent
+     *   instead when the client accepts that coding, with `Vary: Accept-Encoding`.
+     *
+     * Files up to `STATIC_CACHE_FILE_MAX` bytes are kept in a process-wide LRU of
+     * `STATIC_CACHE_SIZE` bytes and copied from memory. Larger files are passed to the session,
+     * which writes the headers and then lets the kernel copy the file to the socket with
+     * `sendfile(2)`; platforms without it stream the file through `set_stream`.
+     */
+    class static_files {
+        std::string root_;
+
+        /// @brief `404` for a file that vanished after its headers were set; drops those headers.
+        static void vanished(Response &res) {
+            for (const auto field: {http::field::etag, http::field::last_modified, http::field::accept_ranges,
+                                    http::field::vary, http::field::content_encoding, http::field::content_range}) {
+                res.erase(field);
+            }
+            set_text(res, "404 Not Found", 404);
+        }
+
+    public:
+        /**
+         * @param root Directory to serve.
+         * @throws std::invalid_argument if @p root is not a directory.
+         */
+        explicit static_files(std::string root) : root_(std::move(root)) {
+            while (root_.size() > 1 && root_.back() == '/') root_.pop_back();
+            struct stat st{};
+            if (::stat(root_.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+                throw std::invalid_argument("static_files: '" + root_ + "' is not a directory");
+            }
+        }
+
+        [[nodiscard]] const std::string &root() const noexcept { return root_; }
+
+        /**
+         * @brief Answer @p req for the file at @p path below the root.
+         * @param path Raw (still percent-encoded) path below the mount, e.g. `css/site.css`.
+         */
+        void serve(const Request &req, Response &res, std::string_view path) const {
+            if (!check_method(req, {http::verb::get, http::verb::head}, res)) return;
+
+            std::string rel;
+            if (!detail::safe_relative_path(path, rel)) return set_text(res, "404 Not Found", 404);
+            std::string file = root_ + "/" + rel;
+            if (rel.empty() || rel.back() == '/') file += "index.html";
+
+            struct stat st{};
+            if (::stat(file.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                file += "/index.html";
+                if (::stat(file.c_str(), &st) != 0) return set_text(res, "404 Not Found", 404);
+            } else if (::stat(file.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+                return set_text(res, "404 Not Found", 404);
+            }
+
+            // Pick the representation: a precompressed sidecar when the client accepts it
+            const bool ranged = req.find(http::field::range) != req.end();
+            std::string_view coding;
+            std::string chosen = file;
+            bool has_sidecar = false;
+            static constexpr std::pair<std::string_view, std::string_view> sidecars[] = {{"br", ".br"},
+                                                                                          {"gzip", ".gz"}};
+            for (const auto &[name, suffix]: sidecars) {
+                std::string candidate = file + std::string(suffix);
+                struct stat cst{};
+                if (::stat(candidate.c_str(), &cst) != 0 || !S_ISREG(cst.st_mode)) continue;
+                has_sidecar = true;
+                if (!ranged && coding.empty() && accepts_encoding(req, name)) {
+                    coding = name;
+                    chosen = std::move(candidate);
+                    st = cst;
+                }
+            }
+
+            const auto size = static_cast<std::uint64_t>(st.st_size);
+            const std::int64_t mtime = detail::mtime_ns(st);
+            char etag[64];
+            const int etag_len = std::snprintf(etag, sizeof(etag), "\"%llx-%llx%s%.*s\"",
+                                               static_cast<unsigned long long>(mtime),
+                                               static_cast<unsigned long long>(size), coding.empty() ? "" : "-",
+                                               static_cast<int>(coding.size()), coding.data());
+            const std::string_view tag(etag, static_cast<std::size_t>(etag_len));
+            const std::string last_modified = detail::http_date(st.st_mtime);
+
+            res.set(http::field::etag, tag);
+            res.set(http::field::last_modified, last_modified);
+            res.set(http::field::accept_ranges, "bytes");
+            if (has_sidecar) res.set(http::field::vary, "Accept-Encoding");
+            if (!coding.empty()) res.set(http::field::content_encoding, coding);
+
+            // Conditional requests: If-None-Match takes precedence over If-Modified-Since
+            const auto inm = req.find(http::field::if_none_match);
+            bool not_modified = false;
+            if (inm != req.end()) {
+                not_modified = detail::etag_matches(inm->value(), tag);
+            } else if (const auto ims = req.find(http::field::if_modified_since); ims != req.end()) {
+                const auto since = detail::parse_http_date(ims->value());
+                not_modified = since && st.st_mtime <= *since;
+            }
+            if (not_modified) {
+                res.result(http::status::not_modified);
+                res.body().clear();
+                return;
+            }
+
+            std::uint64_t first = 0, last = size ? size - 1 : 0;
+            http::status status = http::status::ok;
+            if (ranged) {
+                const auto if_range = req.find(http::field::if_range);
+                const bool current = if_range == req.end() || if_range->value() == tag ||
+                                     if_range->value() == last_modified;
+                const auto result = current ? detail::parse_range(req[http::field::range], size, first, last)
+                                            : detail::range_result::none;
+                if (result == detail::range_result::unsatisfiable) {
+                    res.set(http::field::content_range, "bytes */" + std::to_string(size));
+                    return set_text(res, "416 Range Not Satisfiable", 416);
+                }
+                if (result == detail::range_result::satisfiable) {
+                    status = http::status::partial_content;
+                    res.set(http::field::content_range, "bytes " + std::to_string(first) + "-" +
+                                                        std::to_string(last) + "/" + std::to_string(size));
+                }
+            }
+            const std::uint64_t length = size ? last - first + 1 : 0;
+
+            res.result(status);
+            res.set(http::field::content_type, detail::mime_type(file));
+            res.body().clear();
+            res.content_length(length);
+            if (req.method() == http::verb::head) return;
+
+            if (size <= STATIC_CACHE_FILE_MAX && STATIC_CACHE_SIZE > 0) {
+                auto &cache = detail::static_cache();
+                auto body = cache.find(chosen, mtime, size);
+                if (!body) {
+                    body = detail::read_file(chosen, size);
+                    if (!body) return vanished(res);  // replaced or removed since stat()
+                    cache.insert(chosen, mtime, body);
+                }
+                res.body().assign(*body, first, length);
+                return;
+            }
+
+            detail::unique_fd fd(::open(chosen.c_str(), O_RDONLY | O_CLOEXEC));
+            if (!fd) return vanished(res);
+#if BULGOGI_SENDFILE
+            detail::file_slot() = detail::pending_file{std::move(fd), first, length};
+#else
+            set_stream(res, detail::file_producer(detail::pending_file{std::move(fd), first, length}),
+                       detail::mime_type(file), length, static_cast<int>(status));
+#endif
+        }
+    };
+}
@@ -0,0 +1,146 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <boost/asio/ssl.hpp>
+#include <openssl/ssl.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "marcos.hpp"
+
+
+/**
+ * @brief HTTPS support for builds with `ENABLE_TLS`.
+ *
+ * The server then speaks TLS on `PORT`: every accepted connection is wrapped in a
+ * `boost::beast::ssl_stream`, handshaken, and served by the same session loop as plaintext.
+ *
+ * - Certificate chain and private key are PEM files, `TLS_CERT` / `TLS_KEY` by default,
+ *   overridable through `settings()` in `views::init()`.
+ * - TLS 1.2 and 1.3 only. Resumption is on: TLS 1.3 clients get `TLS_TICKETS` session tickets
+ *   per full handshake (stateless, encrypted with keys OpenSSL generates per process), TLS 1.2
+ *   clients are resumed from tickets or the server-side session cache. Resumed handshakes skip
+ *   the certificate and key exchange signature, which dominate handshake cost.
+ * - With `ENABLE_KTLS`, OpenSSL is asked to hand record encryption to the kernel after the
+ *   handshake (Linux `tls` module, OpenSSL 3 built with kTLS). When that succeeds for the send
+ *   direction, large static files go out with `sendfile(2)` again, encrypted in the kernel; when
+ *   it does not, they are read and encrypted in userspace like any other body.
+ * - ALPN: `h2` is selected when the client offers it and the build has `ENABLE_HTTP2`,
+ *   `http/1.1` otherwise.
+ */
+namespace bulgogi::tls {
+
+    /// @brief Where the certificate and key are loaded from when the server starts.
+    struct options {
+        std::string certificate = TLS_CERT;  ///< PEM certificate chain, leaf first
+        std::string private_key = TLS_KEY;   ///< PEM private key, unencrypted
+    };
+
+    /// @brief Process-wide TLS options; change them in `views::init()`, before the server starts.
+    inline options &settings() {
+        static options current;
+        return current;
+    }
+
+    namespace detail {
+        /// @brief Pick the first protocol of ours (`h2`, then `http/1.1`) the client offers.
+        inline int select_alpn(SSL *, const unsigned char **out, unsigned char *out_length,
+                               const unsigned char *offered, unsigned int offered_length, void *) {
+#ifdef ENABLE_HTTP2
+            static constexpr unsigned char ours[] = "\x02h2\x08http/1.1";
+#else
+            static constexpr unsigned char ours[] = "\x08http/1.1";
+#endif
+            unsigned char *selected = nullptr;
+            if (SSL_select_next_proto(&selected, out_length, ours, sizeof(ours) - 1, offered, offered_length) !=
+                OPENSSL_NPN_NEGOTIATED) {
+                return SSL_TLSEXT_ERR_NOACK;  // no ALPN in the reply, the client falls back to HTTP/1.1
+            }
+            *out = selected;
+            return SSL_TLSEXT_ERR_OK;
+        }
+
+        inline std::atomic<std::uint64_t> handshakes{0};
+        inline std::atomic<std::uint64_t> resumed{0};
+        inline std::atomic<std::uint64_t> failed{0};
+        inline std::atomic<std::uint64_t> ktls{0};
+    }
+
+    /**
+     * @brief Build the server context from @p opt.
+     * @throws boost::system::system_error if the certificate or key cannot be loaded or do not match.
+     */
+    inline boost::asio::ssl::context make_context(const options &opt = settings()) {
+        namespace ssl = boost::asio::ssl;
+        ssl::context ctx(ssl::context::tls_server);
+        ctx.set_options(ssl::context::default_workarounds | ssl::context::no_sslv2 | ssl::context::no_sslv3 |
+                        ssl::context::no_tlsv1 | ssl::context::no_tlsv1_1 | ssl::context::single_dh_use);
+        ctx.use_certificate_chain_file(opt.certificate);
+        ctx.use_private_key_file(opt.private_key, ssl::context::pem);
+
+        SSL_CTX *native = ctx.native_handle();
+        if (SSL_CTX_check_private_key(native) != 1) {
+            throw boost::system::system_error(boost::asio::error::invalid_argument,
+                                              "TLS private key does not match the certificate");
+        }
+
+        // Resumption: server-side cache for TLS 1.2 session ids, tickets for both versions
+        static constexpr unsigned char session_context[] = "bulgogi";
+        SSL_CTX_set_session_id_context(native, session_context, sizeof(session_context) - 1);
+        SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(native, TLS_SESSION_CACHE);
+        SSL_CTX_set_timeout(native, TLS_SESSION_TIMEOUT);
+        SSL_CTX_clear_options(native, SSL_OP_NO_TICKET);
+        SSL_CTX_set_num_tickets(native, TLS_TICKETS);
+
+#if defined(ENABLE_KTLS) && defined(SSL_OP_ENABLE_KTLS)
+        SSL_CTX_set_options(native, SSL_OP_ENABLE_KTLS);
+#endif
+        SSL_CTX_set_alpn_select_cb(native, &detail::select_alpn, nullptr);
+        return ctx;
+    }
+
+    /// @brief Whether the kernel encrypts what is written to the socket of @p ssl (kTLS send).
+    inline bool ktls_send(SSL *ssl) noexcept {
+#if defined(ENABLE_KTLS) && defined(SSL_OP_ENABLE_KTLS)
+        return BIO_get_ktls_send(SSL_get_wbio(ssl)) != 0;
+#else
+        (void) ssl;
+        return false;
+#endif
+    }
+
+    /// @brief Whether ALPN settled on HTTP/2 for @p ssl.
+    inline bool negotiated_h2(SSL *ssl) noexcept {
+        const unsigned char *protocol = nullptr;
+        unsigned int length = 0;
+        SSL_get0_alpn_selected(ssl, &protocol, &length);
+        return length == 2 && std::memcmp(protocol, "h2", 2) == 0;
+    }
+
+    /// @brief Account a finished handshake; @return `ktls_send(ssl)`.
+    inline bool record_handshake(SSL *ssl) noexcept {
+        detail::handshakes.fetch_add(1, std::memory_order_relaxed);
+        if (SSL_session_reused(ssl)) detail::resumed.fetch_add(1, std::memory_order_relaxed);
+        const bool kernel = ktls_send(ssl);
+        if (kernel) detail::ktls.fetch_add(1, std::memory_order_relaxed);
+        return kernel;
+    }
+
+    inline void record_failure() noexcept { detail::failed.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief Completed handshakes.
+    [[maybe_unused]] inline std::uint64_t handshakes() { return detail::handshakes.load(std::memory_order_relaxed); }
+
+    /// @brief Completed handshakes that resumed an earlier session.
+    [[maybe_unused]] inline std::uint64_t resumed() { return detail::resumed.load(std::memory_order_relaxed); }
+
+    /// @brief Handshakes that failed (bad client hello, timeout, unsupported version...).
+    [[maybe_unused]] inline std::uint64_t failed() { return detail::failed.load(std::memory_order_relaxed); }
+
+    /// @brief Connections whose send direction was offloaded to kernel TLS.
+    [[maybe_unused]] inline std::uint64_t ktls() { return detail::ktls.load(std::memory_order_relaxed); }
+}
@@ -10,8 +10,11 @@
  *
  * @section builtin_views Builtin Views
  * The following routes are provided by default:
- * - `/ping` — returns server health status (GET)
+ * - `/ping` — returns server health status (GET, served from a pre-rendered response)
  * - `/shutdown_server` — gracefully shuts down the server (POST)
+ * - `/server_stats` — current and peak session counts, internal networks only (GET)
+ * - `/metrics` — request counts, latency histograms and connection counters in Prometheus
+ *   text format, internal networks only (GET)
  *
  * @section example_views Example Views (commented out)
  * The file includes several example handlers such as:
@@ -29,6 +32,16 @@
 #include "views.hpp"
 #include "bulgogi.hpp"
 #include "template.hpp"
+#include "sessions.hpp"
+#include "metrics.hpp"
+#include "logger.hpp"
+#include "rate_limit.hpp"
+#ifdef ENABLE_TLS
+#include "tls.hpp"
+#endif
+#ifdef ENABLE_HTTP2
+#include "http2.hpp"
+#endif
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/json.hpp>
 #include <iostream>
@@ -69,11 +82,20 @@ namespace cors = bulgogi::cors;
 /// @brief Global function map for registered urls
 std::unordered_map<std::string, views::HandlerFunc> views::function_map;
 
+/// @brief Global pattern list for registered urls with path captures
+std::vector<std::pair<std::string, views::PatternHandlerFunc>> views::pattern_map;
+std::unordered_map<std::string, const bulgogi::cors_policy *> views::cors_map;
+std::unordered_map<std::string, const bulgogi::cache_policy *> views::cache_map;
+std::vector<std::string> views::constant_routes;
+std::unordered_map<std::string, views::body_rule> views::body_map;
+std::vector<std::pair<std::string, std::string>> views::static_map;
+std::vector<std::pair<std::string, views::WebSocketFunc>> views::websocket_map;
+
 /// @brief Atomic boolean to signal server shutdown
 extern std::atomic<bool> g_should_exit;
 
-/// @brief Global acceptor for TCP connections
-extern std::unique_ptr<boost::asio::ip::tcp::acceptor> global_acceptor;
+/// @brief Stop accepting connections and let the io_context threads drain
+void stop_server();
 
 #ifndef NDEBUG
 /// @brief Default root view for the server
@@ -81,6 +103,7 @@ REGISTER_ROOT_VIEW(default_root) {
     if (!check_method(req, bulgogi::http::verb::get, res)) return;
     bulgogi::set_html(res, default_page::html, 200);
 }
+REGISTER_CONSTANT("");
 
 #endif
 
@@ -139,6 +162,7 @@ REGISTER_VIEW(ping) {
     if (!check_method(req, bulgogi::http::verb::get, res)) return;
     set_json(res, {{"status", "alive"}});
 }
+REGISTER_CONSTANT("ping");  // health checks are answered without calling the handler
 
 REGISTER_VIEW(shutdown_server) {
     if (!check_method(req, bulgogi::http::verb::post, res, cors::none)) return;
@@ -146,7 +170,7 @@ REGISTER_VIEW(shutdown_server) {
     if(!bulgogi::ipv4::is_internal_network(remote_ip)){
         set_json(res, {
                 {"error", "Access denied"},
-                {"reason", "Only 127.0.0.1 and private LANs are allowed"}
+                {"reason", "Only internal networks are allowed"}
         }, 403);
         return;
     }
@@ -154,21 +178,100 @@ REGISTER_VIEW(shutdown_server) {
     if (!g_should_exit.exchange(true)) {
         std::cout << "Called Exit\n";
 
-        if (global_acceptor && global_acceptor->is_open()) {
-            boost::system::error_code ec;
-            global_acceptor->cancel(ec); // NOLINT
-        }
-
-        try {
-            boost::asio::io_context ioc;
-            boost::asio::ip::tcp::socket s(ioc);
-            s.connect({boost::asio::ip::address_v4::loopback(), PORT});
-        } catch (...) {}
+        stop_server();
     }
 
     set_json(res, {{"status", "server_shutdown_requested"}});
 }
 
+REGISTER_VIEW(server_stats) {
+    if (!check_method(req, bulgogi::http::verb::get, res, cors::none)) return;
+
+    if (!bulgogi::ipv4::is_internal_network(remote_ip)) {
+        set_json(res, {
+                {"error", "Access denied"},
+                {"reason", "Only internal networks are allowed"}
+        }, 403);
+        return;
+    }
+
+    set_json(res, {
+            {"active_sessions", bulgogi::sessions::active()},
+            {"peak_sessions", bulgogi::sessions::peak()},
+            {"max_sessions", bulgogi::sessions::limit},
+            {"rejected_sessions", bulgogi::sessions::rejected()}
+    });
+}
+
+/// @brief Counters of optional features, appended after `bulgogi::metrics::render`.
+static void render_feature_metrics(std::string &out) {
+    using bulgogi::metrics::append_scalar;
+    namespace rate_limit = bulgogi::rate_limit;
+    namespace websocket = bulgogi::websocket;
+    namespace response_cache = bulgogi::response_cache;
+
+    append_scalar(out, "bulgogi_rate_limited_connections_total", "counter",
+                  "Connections answered with 429 under RATE_LIMIT_CONNECTIONS.", rate_limit::rejected_connections());
+    append_scalar(out, "bulgogi_rate_limited_requests_total", "counter",
+                  "Requests answered with 429 under RATE_LIMIT_REQUESTS.", rate_limit::rejected_requests());
+    append_scalar(out, "bulgogi_websocket_connections", "gauge", "WebSocket connections currently open.",
+                  websocket::open());
+    append_scalar(out, "bulgogi_websocket_accepted_total", "counter", "Completed WebSocket handshakes.",
+                  websocket::accepted());
+    append_scalar(out, "bulgogi_websocket_published_total", "counter",
+                  "Messages published to topics with subscribers.", websocket::published());
+    append_scalar(out, "bulgogi_websocket_dropped_total", "counter",
+                  "Messages dropped for a full write queue under WEBSOCKET_DROP_SLOW.", websocket::dropped());
+    append_scalar(out, "bulgogi_websocket_slow_closed_total", "counter",
+                  "WebSocket connections closed because their write queue was full.", websocket::slow_closed());
+    const auto [cache_entries, cache_bytes] = response_cache::usage();
+    append_scalar(out, "bulgogi_response_cache_hits_total", "counter", "Requests answered from the response cache.",
+                  response_cache::hits());
+    append_scalar(out, "bulgogi_response_cache_misses_total", "counter", "Cacheable requests that ran their handler.",
+                  response_cache::misses());
+    append_scalar(out, "bulgogi_response_cache_stores_total", "counter", "Responses stored in the response cache.",
+                  response_cache::stores());
+    append_scalar(out, "bulgogi_response_cache_evictions_total", "counter",
+                  "Cached responses evicted to stay under RESPONSE_CACHE_SIZE.", response_cache::evictions());
+    append_scalar(out, "bulgogi_response_cache_entries", "gauge", "Responses currently cached.", cache_entries);
+    append_scalar(out, "bulgogi_response_cache_bytes", "gauge", "Bytes held by the response cache.", cache_bytes);
+#ifdef ENABLE_TLS
+    append_scalar(out, "bulgogi_tls_handshakes_total", "counter", "Completed TLS handshakes.",
+                  bulgogi::tls::handshakes());
+    append_scalar(out, "bulgogi_tls_resumed_total", "counter", "TLS handshakes that resumed a session.",
+                  bulgogi::tls::resumed());
+    append_scalar(out, "bulgogi_tls_failed_total", "counter", "TLS handshakes that failed.", bulgogi::tls::failed());
+    append_scalar(out, "bulgogi_tls_ktls_total", "counter", "TLS connections sending through kernel TLS.",
+                  bulgogi::tls::ktls());
+#endif
+#ifdef ENABLE_HTTP2
+    append_scalar(out, "bulgogi_http2_connections_total", "counter", "Connections that switched to HTTP/2.",
+                  bulgogi::http2::connections());
+    append_scalar(out, "bulgogi_http2_streams_total", "counter", "Requests received over HTTP/2.",
+                  bulgogi::http2::streams());
+#endif
+    append_scalar(out, "bulgogi_log_dropped_total", "counter", "Log lines dropped because the log ring was full.",
+                  bulgogi::log::dropped());
+}
+
+REGISTER_VIEW(metrics) {
+    if (!check_method(req, bulgogi::http::verb::get, res, cors::none)) return;
+
+    if (!bulgogi::ipv4::is_internal_network(remote_ip)) {
+        set_json(res, {
+                {"error", "Access denied"},
+                {"reason", "Only internal networks are allowed"}
+        }, 403);
+        return;
+    }
+
+    res.result(bulgogi::http::status::ok);
+    res.set(bulgogi::http::field::content_type, "text/plain; version=0.0.4; charset=utf-8");
+    bulgogi::metrics::render(res.body());
+    render_feature_metrics(res.body());
+    res.prepare_payload();
+}
+
 
 /**
  * @page example_views HTTP Method Examples
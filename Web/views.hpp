@@ -4,19 +4,99 @@
 
 #pragma once
 
+#include <cstdint>
+#include <initializer_list>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "bulgogi.hpp"
+#include "cors.hpp"
+#include "path_router.hpp"
+#include "websocket.hpp"
+#include "response_cache.hpp"
 #include "marcos.hpp"
 
 
 namespace views {
 
-    using HandlerFunc = void (*)(const bulgogi::Request &req, bulgogi::Response &res, const std::string &ip);
+    using HandlerFunc = void (*)(const bulgogi::Request &req, bulgogi::Response &res, const bulgogi::remote_address &ip);
+
+    using PatternHandlerFunc = void (*)(const bulgogi::Request &req, bulgogi::Response &res,
+                                        const bulgogi::path_params &params, const bulgogi::remote_address &ip);
+
+    using WebSocketFunc = void (*)(const bulgogi::Request &req, bulgogi::websocket::upgrade &ws,
+                                   const bulgogi::remote_address &ip);
 
     // Declare global function map
     extern std::unordered_map<std::string, HandlerFunc> function_map;
 
+    // Declare global pattern list, matched only when no exact route exists
+    extern std::vector<std::pair<std::string, PatternHandlerFunc>> pattern_map;
+
+    // Declare global CORS policies by route or pattern string, see REGISTER_CORS
+    extern std::unordered_map<std::string, const bulgogi::cors_policy *> cors_map;
+
+    // Declare global response cache policies by route or pattern string, see REGISTER_CACHE
+    extern std::unordered_map<std::string, const bulgogi::cache_policy *> cache_map;
+
+    // Declare global list of exact routes answered from a response rendered at start-up
+    extern std::vector<std::string> constant_routes;
+
+    // Declare global static mounts (URL prefix, directory), matched after patterns
+    extern std::vector<std::pair<std::string, std::string>> static_map;
+
+    // Declare global WebSocket routes, see REGISTER_WEBSOCKET
+    extern std::vector<std::pair<std::string, WebSocketFunc>> websocket_map;
+
+    /// @brief Request body handling declared with `REGISTER_BODY_LIMIT` / `REGISTER_STREAMING_BODY`.
+    struct body_rule {
+        std::uint64_t limit = MAX_BODY_SIZE;
+        bool streaming = false;
+    };
+
+    // Declare global body rules by route or pattern string
+    extern std::unordered_map<std::string, body_rule> body_map;
+
+    struct static_registrar {
+        static_registrar(const char *prefix, const char *root) { static_map.emplace_back(prefix, root); }
+    };
+
+    struct pattern_registrar {
+        pattern_registrar(PatternHandlerFunc func, std::initializer_list<const char *> patterns) {
+            for (const auto *p: patterns) pattern_map.emplace_back(p, func);
+        }
+    };
+
+    struct cors_registrar {
+        cors_registrar(const bulgogi::cors_policy &policy, std::initializer_list<const char *> paths) {
+            for (const auto *p: paths) cors_map[p] = &policy;
+        }
+    };
+
+    struct constant_registrar {
+        constant_registrar(std::initializer_list<const char *> paths) {
+            for (const auto *p: paths) constant_routes.emplace_back(p);
+        }
+    };
+
+    struct body_registrar {
+        body_registrar(body_rule rule, std::initializer_list<const char *> paths) {
+            for (const auto *p: paths) body_map[p] = rule;
+        }
+    };
+
+    struct websocket_registrar {
+        websocket_registrar(WebSocketFunc func, std::initializer_list<const char *> paths) {
+            for (const auto *p: paths) websocket_map.emplace_back(p, func);
+        }
+    };
+
+    struct cache_registrar {
+        cache_registrar(const bulgogi::cache_policy &policy, std::initializer_list<const char *> paths) {
+            for (const auto *p: paths) cache_map[p] = &policy;
+        }
+    };
+
     /**
      * @brief Register a view handler for a nested URL path.
      *
@@ -32,14 +112,14 @@ namespace views {
      */
 #define REGISTER_VIEW(...) \
         void ROUTE_NAME(__VA_ARGS__)(const bulgogi::Request& req, \
-                       bulgogi::Response& res, const std::string& remote_ip); \
+                       bulgogi::Response& res, const bulgogi::remote_address& remote_ip); \
         struct EXPAND(ROUTE_NAME(__VA_ARGS__), _registrar) { \
             EXPAND(ROUTE_NAME(__VA_ARGS__), _registrar)() { \
                 views::function_map[ROUTE_STR(__VA_ARGS__)] = ROUTE_NAME(__VA_ARGS__); \
             } \
         } EXPAND(ROUTE_NAME(__VA_ARGS__), _registrar_instance); \
         void ROUTE_NAME(__VA_ARGS__)(const bulgogi::Request& req, \
-                       bulgogi::Response& res, [[maybe_unused]] const std::string& remote_ip)
+                       bulgogi::Response& res, [[maybe_unused]] const bulgogi::remote_address& remote_ip)
 
     /**
      * @brief Register one or more URL paths for a single handler function.
@@ -73,7 +153,7 @@ namespace views {
      */
 #define REGISTER_VIEW_URLS(func_name, ...) \
         void func_name(const bulgogi::Request& req, \
-                       bulgogi::Response& res, const std::string& remote_ip); \
+                       bulgogi::Response& res, const bulgogi::remote_address& remote_ip); \
         struct func_name##_alias_registrar { \
             func_name##_alias_registrar() { \
                 const char* paths[] = { __VA_ARGS__ }; \
@@ -81,7 +161,7 @@ namespace views {
             } \
         } func_name##_alias_registrar_instance; \
         void func_name(const bulgogi::Request& req, \
-                       bulgogi::Response& res, [[maybe_unused]] const std::string& remote_ip)
+                       bulgogi::Response& res, [[maybe_unused]] const bulgogi::remote_address& remote_ip)
 
     /**
      * @brief Register the handler for the root URL path ("/").
@@ -105,6 +185,191 @@ namespace views {
      * @endcode
      */
 #define REGISTER_ROOT_VIEW(func_name) REGISTER_VIEW_URLS(func_name, "")
+
+    /**
+     * @brief Register one or more path patterns with captures for a single handler function.
+     *
+     * Patterns follow the `REGISTER_VIEW_URLS(...)` rules (string literals, no leading slash) and
+     * may contain captures, one per segment:
+     * - `{name}` or `{name:str}` — any non-empty segment;
+     * - `{name:int}`             — decimal digits with an optional leading `-`;
+     * - `{*name}`                — the rest of the path, slashes included (last segment only).
+     *
+     * The handler receives an extra `params` argument holding the captures as `std::string_view`s
+     * into the request target (valid during the call only).
+     *
+     * Example:
+     * @code
+     * REGISTER_VIEW_PATTERN(get_user, "api/user/{id:int}") {
+     *     if (!check_method(req, bulgogi::http::verb::get, res)) return;
+     *     auto id = params.get<std::int64_t>("id").value_or(0);
+     *     bulgogi::set_json(res, {{"id", id}});
+     * }
+     * @endcode
+     *
+     * Notes:
+     * - Exact routes registered with `REGISTER_VIEW(...)`/`REGISTER_VIEW_URLS(...)` are always
+     *   looked up first and keep their fast path; patterns are only tried when they miss.
+     * - Among patterns, literal segments win over `int` captures, which win over plain captures,
+     *   which win over wildcards.
+     * - Malformed patterns are rejected with `std::invalid_argument` when the server starts.
+     */
+#define REGISTER_VIEW_PATTERN(func_name, ...) \
+        void func_name(const bulgogi::Request& req, bulgogi::Response& res, \
+                       const bulgogi::path_params& params, const bulgogi::remote_address& remote_ip); \
+        static views::pattern_registrar EXPAND(bulgogi_pattern_registrar_, __COUNTER__){func_name, {__VA_ARGS__}}; \
+        void func_name(const bulgogi::Request& req, bulgogi::Response& res, \
+                       [[maybe_unused]] const bulgogi::path_params& params, \
+                       [[maybe_unused]] const bulgogi::remote_address& remote_ip)
+
+    /**
+     * @brief Attach a `bulgogi::cors_policy` to one or more routes.
+     *
+     * Paths are written exactly as registered with `REGISTER_VIEW_URLS(...)` or
+     * `REGISTER_VIEW_PATTERN(...)` (string literals, no leading slash). Preflight `OPTIONS`
+     * requests on these routes are answered by the server from the policy's pre-rendered
+     * response, without calling the handler, when the request's `Origin` is allowed; the handler
+     * still enforces the policy for other methods through `check_method(req, policy, res)`.
+     *
+     * Example:
+     * @code
+     * inline const bulgogi::cors_policy user_cors{{bulgogi::http::verb::get}, "https://app.example.com"};
+     * REGISTER_CORS(user_cors, "api/user/info", "api/user/{id:int}");
+     * @endcode
+     */
+#define REGISTER_CORS(policy, ...) \
+        static views::cors_registrar EXPAND(bulgogi_cors_registrar_, __COUNTER__){policy, {__VA_ARGS__}}
+
+    /**
+     * @brief Answer `GET`/`HEAD` on exact routes from a response rendered once at start-up.
+     *
+     * For fixed endpoints such as health checks. When the server starts, the handler of each
+     * listed route is called once with a synthetic `GET` request (no body, no query, empty
+     * remote address) and its response is serialized into wire-ready buffers. From then on,
+     * `GET` requests without an `Origin` header are answered with those bytes directly: no handler
+     * call, no JSON building, no allocation for the response. `HEAD` is answered the same way only
+     * if a synthetic `HEAD` sent to the handler at start-up got a `2xx`, so a handler that refuses
+     * `HEAD` keeps refusing it. Other methods and cross-origin requests still go through the handler.
+     *
+     * Only use it for handlers whose `GET` response does not depend on the request or on state.
+     * Listing a path that is not an exact route, or a handler that streams its body, stops the
+     * server at start-up with `std::invalid_argument`.
+     *
+     * Example:
+     * @code
+     * REGISTER_VIEW(ping) { ... }
+     * REGISTER_CONSTANT("ping");
+     * @endcode
+     */
+#define REGISTER_CONSTANT(...) \
+        static views::constant_registrar EXPAND(bulgogi_constant_registrar_, __COUNTER__){__VA_ARGS__}
+
+    /**
+     * @brief Accept request bodies of up to @p bytes on one or more routes instead of `MAX_BODY_SIZE`.
+     *
+     * Paths are written exactly as registered (string literals, no leading slash). A request whose
+     * `Content-Length` exceeds the limit is answered with `413` as soon as its headers are read,
+     * before any of the body is (a client sending `Expect: 100-continue` never sends it); a chunked
+     * body is cut off with `413` once it grows past the limit. Either way the connection is closed.
+     *
+     * Example:
+     * @code
+     * REGISTER_BODY_LIMIT(16 * 1024, "api/login");            // small JSON only
+     * REGISTER_BODY_LIMIT(64 * 1024 * 1024, "api/import");    // 64 MiB, buffered
+     * @endcode
+     *
+     * Listing a path that is not a registered view or pattern stops the server at start-up with
+     * `std::invalid_argument`.
+     */
+#define REGISTER_BODY_LIMIT(bytes, ...) \
+        static views::body_registrar EXPAND(bulgogi_body_registrar_, __COUNTER__){ \
+            views::body_rule{bytes, false}, {__VA_ARGS__}}
+
+    /**
+     * @brief Hand request bodies of up to @p bytes to the handler piece by piece (see
+     *        `bulgogi::receive_body`) instead of buffering them in `req.body()`.
+     *
+     * The handler runs once the headers are read, so it can refuse an upload (authentication,
+     * quota, content type) before the body is transferred. Limits work as with
+     * `REGISTER_BODY_LIMIT`; use `bulgogi::unlimited_body` for none.
+     */
+#define REGISTER_STREAMING_BODY(bytes, ...) \
+        static views::body_registrar EXPAND(bulgogi_body_registrar_, __COUNTER__){ \
+            views::body_rule{bytes, true}, {__VA_ARGS__}}
+
+    /**
+     * @brief Cache the `GET` responses of one or more routes under a `bulgogi::cache_policy`.
+     *
+     * Paths are written as for `REGISTER_CORS`. Later `GET`/`HEAD` requests with the same path,
+     * query parameters (in any order) and `vary` headers are answered from the stored bytes without
+     * calling the handler, until the response's `max-age` (or the policy's `ttl`) runs out or
+     * `bulgogi::response_cache::invalidate(path)` drops it. See `bulgogi::response_cache` for what
+     * is stored.
+     *
+     * Example:
+     * @code
+     * inline const bulgogi::cache_policy catalog_cache{std::chrono::seconds(300), {"Accept-Language"}};
+     * REGISTER_CACHE(catalog_cache, "api/catalog", "api/item/{id:int}");
+     *
+     * REGISTER_VIEW_PATTERN(update_item, "api/item/{id:int}/update") {
+     *     // ... store the change, then
+     *     bulgogi::response_cache::invalidate("api/item/" + std::string(params["id"]));
+     * }
+     * @endcode
+     *
+     * Listing a path that is not a registered view or pattern stops the server at start-up with
+     * `std::invalid_argument`.
+     */
+#define REGISTER_CACHE(policy, ...) \
+        static views::cache_registrar EXPAND(bulgogi_cache_registrar_, __COUNTER__){policy, {__VA_ARGS__}}
+
+    /**
+     * @brief Serve the files of a directory below a URL prefix.
+     *
+     * `REGISTER_STATIC("assets", "/var/www")` answers `/assets/css/site.css` with
+     * `/var/www/css/site.css` (see `bulgogi::static_files` for conditional requests, ranges,
+     * precompressed sidecars and caching).
+     *
+     * Notes:
+     * - The prefix follows the `REGISTER_VIEW_URLS(...)` rules (no leading slash); `""` mounts the
+     *   directory at the root.
+     * - Exact routes and patterns are looked up first, so views can live under the same prefix.
+     * - A root that is not a directory is rejected with `std::invalid_argument` when the server starts.
+     * - Dotfiles and paths leaving the root are never served.
+     */
+#define REGISTER_STATIC(prefix, root) \
+        static views::static_registrar EXPAND(bulgogi_static_registrar_, __COUNTER__){prefix, root}
+
+    /**
+     * @brief Accept WebSocket connections on one or more URL paths.
+     *
+     * Paths follow the `REGISTER_VIEW_URLS(...)` rules. The handler is called with the upgrade
+     * request and a `bulgogi::websocket::upgrade` named `ws` to fill in; leaving it untouched still
+     * accepts the connection (and ignores what it sends), `ws.reject(status)` refuses it.
+     *
+     * Example:
+     * @code
+     * REGISTER_WEBSOCKET(prices_feed, "live/prices") {
+     *     if (!bulgogi::ipv4::is_internal_network(remote_ip)) return ws.reject(403);
+     *     ws.topics.emplace_back("prices");  // fed by bulgogi::websocket::publish("prices", ...)
+     *     ws.on_message = [](bulgogi::websocket::connection &c, std::string_view data, bool) {
+     *         if (data == "ping") c.send("pong");
+     *     };
+     * }
+     * @endcode
+     *
+     * Notes:
+     * - Only HTTP/1.1 upgrade requests reach the handler. Other requests to the path are served by a
+     *   view registered on the same path, or answered with `426 Upgrade Required`.
+     * - The upgrade request counts towards the route's metrics and rate limit; the connection keeps
+     *   its `MAX_SESSIONS` slot until it is closed.
+     */
+#define REGISTER_WEBSOCKET(func_name, ...) \
+        void func_name(const bulgogi::Request& req, bulgogi::websocket::upgrade& ws, \
+                       const bulgogi::remote_address& remote_ip); \
+        static views::websocket_registrar EXPAND(bulgogi_websocket_registrar_, __COUNTER__){func_name, {__VA_ARGS__}}; \
+        void func_name([[maybe_unused]] const bulgogi::Request& req, bulgogi::websocket::upgrade& ws, \
+                       [[maybe_unused]] const bulgogi::remote_address& remote_ip)
 }
 
 namespace views {
@@ -114,11 +379,4 @@ namespace views {
 
     /// @brief Call this function to clean up resources before exiting
     void atexit();
-
-    // Returns true if a view exists for this path
-    inline bool has_route(std::string_view path) {
-        if (path.empty()) return function_map.contains("");
-        if (path[0] == '/') path.remove_prefix(1);
-        return function_map.contains(std::string(path));
-    }
 }
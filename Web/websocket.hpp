@@ -0,0 +1,331 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <boost/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "marcos.hpp"
+#include "address.hpp"
+
+
+/**
+ * @brief WebSocket routes (`REGISTER_WEBSOCKET`) and topic broadcast.
+ *
+ * A `REGISTER_WEBSOCKET` handler is called with the HTTP/1.1 upgrade request and fills in an
+ * `upgrade`: callbacks for the connection's life and the topics it joins. The server then
+ * completes the handshake with `boost::beast::websocket` on the same strand the HTTP session ran on.
+ *
+ * Sending never blocks and never waits for the peer:
+ * - Every connection has a write queue drained by one asynchronous write at a time. `send()` may
+ *   be called from any thread; the message is queued on the connection's strand.
+ * - A `message` is built once and shared: `publish()` hands the same buffer to every subscriber of
+ *   a topic, and each connection writes it out behind its own frame header. Frames are neither
+ *   compressed nor fragmented, so the payload is never copied per connection.
+ * - Queued bytes per connection are capped at `WEBSOCKET_QUEUE_LIMIT`. A consumer that falls
+ *   further behind is closed with `1013 Try Again Later` (the client reconnects and resynchronises),
+ *   or, with `WEBSOCKET_DROP_SLOW`, loses the messages that do not fit. One message is always
+ *   accepted into an empty queue, whatever its size.
+ */
+namespace bulgogi::websocket {
+
+    /// @name Close codes sent by the server (RFC 6455, section 7.4)
+    /// @{
+    inline constexpr std::uint16_t normal = 1000;
+    inline constexpr std::uint16_t going_away = 1001;       ///< server shutting down
+    inline constexpr std::uint16_t internal_error = 1011;   ///< a callback threw
+    inline constexpr std::uint16_t try_again_later = 1013;  ///< write queue over `WEBSOCKET_QUEUE_LIMIT`
+    /// @}
+
+    /// @brief Bytes a connection may have queued for writing.
+    inline constexpr std::size_t queue_limit = WEBSOCKET_QUEUE_LIMIT;
+
+    /// @brief An outgoing message, immutable once built and shared by every connection it goes to.
+    struct frame {
+        std::string payload;
+        bool binary = false;
+    };
+
+    using message = std::shared_ptr<const frame>;
+
+    [[nodiscard]] inline message make_text(std::string payload) {
+        return std::make_shared<const frame>(frame{std::move(payload), false});
+    }
+
+    [[nodiscard]] inline message make_binary(std::string payload) {
+        return std::make_shared<const frame>(frame{std::move(payload), true});
+    }
+
+    [[nodiscard]] inline message make_json(const boost::json::value &value) {
+        return make_text(boost::json::serialize(value));
+    }
+
+    class connection;
+
+    /**
+     * @brief What a `REGISTER_WEBSOCKET` handler sets up for the connection it accepts.
+     *
+     * Callbacks run on the connection's strand, one at a time; `on_message` gets the payload of a
+     * whole message (at most `MAX_BODY_SIZE` bytes), valid during the call only.
+     */
+    struct upgrade {
+        std::function<void(connection &)> on_open;
+        std::function<void(connection &, std::string_view data, bool binary)> on_message;
+        std::function<void(connection &)> on_close;  ///< after the connection left its topics
+        std::vector<std::string> topics;              ///< joined before `on_open`
+        unsigned status = 0;                          ///< set by `reject()`
+
+        /// @brief Refuse the upgrade: the request is answered with @p code and no handshake.
+        void reject(unsigned code = 403) noexcept { status = code; }
+    };
+
+    namespace detail {
+        inline std::atomic<std::size_t> open{0};
+        inline std::atomic<std::uint64_t> accepted{0};
+        inline std::atomic<std::uint64_t> published{0};
+        inline std::atomic<std::uint64_t> dropped{0};
+        inline std::atomic<std::uint64_t> slow_closed{0};
+
+        struct topic_hash {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view topic) const noexcept {
+                return std::hash<std::string_view>{}(topic);
+            }
+        };
+
+        using subscriber = std::pair<const connection *, std::weak_ptr<connection>>;
+
+        /// @brief Topic subscriptions and the open connections, for `publish()` and shutdown.
+        struct hub {
+            std::shared_mutex mutex;
+            std::unordered_map<std::string, std::vector<subscriber>, topic_hash, std::equal_to<>> topics;
+            std::unordered_map<const connection *, std::weak_ptr<connection>> live;
+        };
+
+        inline hub &registry() {
+            static hub instance;
+            return instance;
+        }
+
+        /// @brief Strong references to what @p weak points to, taken under the caller's lock.
+        template<typename Range>
+        std::vector<std::shared_ptr<connection>> lock_all(const Range &weak) {
+            std::vector<std::shared_ptr<connection>> out;
+            out.reserve(weak.size());
+            for (const auto &[_, w]: weak) {
+                if (auto c = w.lock()) out.push_back(std::move(c));
+            }
+            return out;
+        }
+    }
+
+    /**
+     * @brief An open WebSocket connection, as seen by callbacks and by code holding on to it
+     *        (`shared_from_this()`) to send later.
+     *
+     * Every member function is thread-safe.
+     */
+    class connection : public std::enable_shared_from_this<connection> {
+    public:
+        explicit connection(const remote_address &ip) : remote_ip_(ip) {}
+
+        virtual ~connection() = default;
+
+        connection(const connection &) = delete;
+        connection &operator=(const connection &) = delete;
+
+        /**
+         * @brief Queue @p m for writing.
+         * @return false if the connection is closing, or the message did not fit the write queue
+         *         (the connection is then closed, or the message dropped with `WEBSOCKET_DROP_SLOW`).
+         */
+        bool send(message m) {
+            if (!m || closed_.load(std::memory_order_acquire)) return false;
+            const std::size_t size = m->payload.size();
+            const std::size_t before = queued_.fetch_add(size, std::memory_order_acq_rel);
+            if (before != 0 && before + size > queue_limit) {
+                queued_.fetch_sub(size, std::memory_order_acq_rel);
+#ifdef WEBSOCKET_DROP_SLOW
+                detail::dropped.fetch_add(1, std::memory_order_relaxed);
+#else
+                if (close(try_again_later)) detail::slow_closed.fetch_add(1, std::memory_order_relaxed);
+#endif
+                return false;
+            }
+            enqueue(std::move(m));
+            return true;
+        }
+
+        /// @brief Queue a text message holding a copy of @p text.
+        bool send(std::string_view text) { return send(make_text(std::string(text))); }
+
+        /**
+         * @brief Start the closing handshake with @p code once the message being written is out;
+         *        messages still queued are discarded.
+         * @return false if the connection was already closing.
+         */
+        bool close(std::uint16_t code = normal) {
+            if (closed_.exchange(true, std::memory_order_acq_rel)) return false;
+            shut(code);
+            return true;
+        }
+
+        /// @brief Receive what is published to @p topic from now on; ignored once closed.
+        void subscribe(const std::string &topic) {
+            std::lock_guard own(topics_mutex_);  // always taken before the hub's lock
+            if (closed_.load(std::memory_order_acquire)) return;
+            if (std::find(topics_.begin(), topics_.end(), topic) != topics_.end()) return;
+            topics_.push_back(topic);
+            auto &hub = detail::registry();
+            std::unique_lock lock(hub.mutex);
+            hub.topics[topic].emplace_back(this, weak_from_this());
+        }
+
+        void unsubscribe(const std::string &topic) {
+            std::lock_guard own(topics_mutex_);
+            const auto it = std::find(topics_.begin(), topics_.end(), topic);
+            if (it == topics_.end()) return;
+            topics_.erase(it);
+            auto &hub = detail::registry();
+            std::unique_lock lock(hub.mutex);
+            leave(hub, topic);
+        }
+
+        [[nodiscard]] const remote_address &remote_ip() const noexcept { return remote_ip_; }
+
+        /// @brief Bytes waiting in the write queue, the message being written included.
+        [[nodiscard]] std::size_t queued() const noexcept { return queued_.load(std::memory_order_relaxed); }
+
+        [[nodiscard]] bool is_open() const noexcept { return !closed_.load(std::memory_order_acquire); }
+
+    protected:
+        /// @brief Append @p m to the write queue, on the connection's strand.
+        virtual void enqueue(message m) = 0;
+
+        /// @brief Send a close frame with @p code, on the connection's strand; called once.
+        virtual void shut(std::uint16_t code) = 0;
+
+        /// @brief A queued message of @p bytes was written or discarded.
+        void dequeued(std::size_t bytes) noexcept { queued_.fetch_sub(bytes, std::memory_order_acq_rel); }
+
+        /// @brief The handshake is done: count the connection and make it reachable for shutdown.
+        void opened() {
+            detail::open.fetch_add(1, std::memory_order_relaxed);
+            detail::accepted.fetch_add(1, std::memory_order_relaxed);
+            auto &hub = detail::registry();
+            std::unique_lock lock(hub.mutex);
+            hub.live.emplace(this, weak_from_this());
+        }
+
+        /// @brief The connection is gone: stop sends and leave every topic.
+        void closed() {
+            closed_.store(true, std::memory_order_release);
+            std::lock_guard own(topics_mutex_);
+            auto &hub = detail::registry();
+            std::unique_lock lock(hub.mutex);
+            for (const auto &topic: topics_) leave(hub, topic);
+            topics_.clear();
+            if (hub.live.erase(this)) detail::open.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+    private:
+        void leave(detail::hub &hub, const std::string &topic) const {
+            const auto it = hub.topics.find(topic);
+            if (it == hub.topics.end()) return;
+            auto &subscribers = it->second;
+            for (std::size_t i = 0; i < subscribers.size(); ++i) {
+                if (subscribers[i].first != this) continue;
+                subscribers[i] = std::move(subscribers.back());
+                subscribers.pop_back();
+                break;
+            }
+            if (subscribers.empty()) hub.topics.erase(it);
+        }
+
+        remote_address remote_ip_;
+        std::atomic<std::size_t> queued_{0};
+        std::atomic<bool> closed_{false};
+        std::mutex topics_mutex_;
+        std::vector<std::string> topics_;
+    };
+
+    /**
+     * @brief Send @p m to every connection subscribed to @p topic.
+     *
+     * The subscriber list is copied under a shared lock and the message queued outside of it, so
+     * publishing from many threads does not serialise, and a slow consumer being closed does not
+     * hold up the others.
+     * @return The number of connections the message was queued for.
+     */
+    inline std::size_t publish(std::string_view topic, const message &m) {
+        std::vector<std::shared_ptr<connection>> targets;
+        {
+            auto &hub = detail::registry();
+            std::shared_lock lock(hub.mutex);
+            const auto it = hub.topics.find(topic);
+            if (it == hub.topics.end()) return 0;
+            targets = detail::lock_all(it->second);
+        }
+        detail::published.fetch_add(1, std::memory_order_relaxed);
+        std::size_t delivered = 0;
+        for (const auto &c: targets) delivered += c->send(m);
+        return delivered;
+    }
+
+    /// @brief Publish @p text as a text message.
+    inline std::size_t publish(std::string_view topic, std::string text) {
+        return publish(topic, make_text(std::move(text)));
+    }
+
+    /// @brief Publish @p value serialised once as a JSON text message.
+    inline std::size_t publish_json(std::string_view topic, const boost::json::value &value) {
+        return publish(topic, make_json(value));
+    }
+
+    /// @brief Number of connections subscribed to @p topic.
+    [[maybe_unused]] inline std::size_t subscribers(std::string_view topic) {
+        auto &hub = detail::registry();
+        std::shared_lock lock(hub.mutex);
+        const auto it = hub.topics.find(topic);
+        return it == hub.topics.end() ? 0 : it->second.size();
+    }
+
+    /// @brief Close every open connection with @p code; called on shutdown.
+    inline void close_all(std::uint16_t code = going_away) {
+        std::vector<std::shared_ptr<connection>> targets;
+        {
+            auto &hub = detail::registry();
+            std::shared_lock lock(hub.mutex);
+            targets = detail::lock_all(hub.live);
+        }
+        for (const auto &c: targets) c->close(code);
+    }
+
+    /// @brief Connections currently open.
+    [[maybe_unused]] inline std::size_t open() { return detail::open.load(std::memory_order_relaxed); }
+
+    /// @brief Completed handshakes since start-up.
+    [[maybe_unused]] inline std::uint64_t accepted() { return detail::accepted.load(std::memory_order_relaxed); }
+
+    /// @brief Calls to `publish()` on a topic that had subscribers.
+    [[maybe_unused]] inline std::uint64_t published() { return detail::published.load(std::memory_order_relaxed); }
+
+    /// @brief Messages dropped because the receiver's queue was full (`WEBSOCKET_DROP_SLOW`).
+    [[maybe_unused]] inline std::uint64_t dropped() { return detail::dropped.load(std::memory_order_relaxed); }
+
+    /// @brief Connections closed because their queue was full.
+    [[maybe_unused]] inline std::uint64_t slow_closed() { return detail::slow_closed.load(std::memory_order_relaxed); }
+}
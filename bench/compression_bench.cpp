@@ -0,0 +1,64 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+// bench/compression_bench.cpp
+
+/**
+ * @file compression_bench.cpp
+ * @brief Response compression: throughput against ratio per coding and level.
+ *
+ * The payload is a list-endpoint style JSON body of the given size. Every iteration compresses
+ * it with a context that lives across iterations, as the server's per-thread contexts do.
+ * `bytes_per_second` is input throughput; the `ratio` counter is input size / output size.
+ * Arguments are `{body bytes, level}` (zlib level 1–9, brotli quality 0–11).
+ */
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include "../Web/compression.hpp"
+
+namespace {
+
+    std::string make_body(std::size_t size) {
+        std::string body = "{\"rows\":[";
+        for (std::size_t i = 0; body.size() < size; ++i) {
+            body += "{\"id\":" + std::to_string(i) + ",\"name\":\"user " + std::to_string(i * 7919 % 1000) +
+                    "\",\"score\":" + std::to_string(i % 97) + ".5,\"active\":" + (i % 3 ? "true" : "false") + "},";
+        }
+        body.resize(size);
+        return body;
+    }
+
+    template<int WindowBits>
+    void BM_Zlib(benchmark::State &state) {
+        const std::string body = make_body(static_cast<std::size_t>(state.range(0)));
+        bulgogi::compression::detail::zlib_context context(WindowBits, static_cast<int>(state.range(1)));
+        std::string out;
+        for (auto _: state) {
+            context.compress(body, out);
+            benchmark::DoNotOptimize(out.data());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * body.size()));
+        state.counters["ratio"] = static_cast<double>(body.size()) / static_cast<double>(out.size());
+    }
+
+#if BULGOGI_BROTLI
+    void BM_Brotli(benchmark::State &state) {
+        const std::string body = make_body(static_cast<std::size_t>(state.range(0)));
+        std::string out;
+        for (auto _: state) {
+            bulgogi::compression::detail::brotli_compress(body, out, static_cast<int>(state.range(1)));
+            benchmark::DoNotOptimize(out.data());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * body.size()));
+        state.counters["ratio"] = static_cast<double>(body.size()) / static_cast<double>(out.size());
+    }
+#endif
+}
+
+BENCHMARK(BM_Zlib<15 + 16>)->Name("BM_Gzip")->ArgsProduct({{4 << 10, 64 << 10, 1 << 20}, {1, 6, 9}});
+BENCHMARK(BM_Zlib<15>)->Name("BM_Deflate")->ArgsProduct({{4 << 10, 64 << 10, 1 << 20}, {1, 6, 9}});
+#if BULGOGI_BROTLI
+BENCHMARK(BM_Brotli)->ArgsProduct({{4 << 10, 64 << 10, 1 << 20}, {1, 4, 6, 11}});
+#endif
+
+BENCHMARK_MAIN();
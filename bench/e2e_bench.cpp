@@ -0,0 +1,935 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+// bench/e2e_bench.cpp
+
+/**
+ * @file e2e_bench.cpp
+ * @brief End-to-end load generator (`bulgogi_bench`) against the real server on loopback.
+ *
+ * The server from `main.cpp` is linked in (without its `main`) and started on an ephemeral
+ * `127.0.0.1` port, so every request goes through the kernel socket, the session loop and
+ * `handle_request` exactly as in production. Blocking client threads, one connection each, then
+ * hammer one route for a fixed time:
+ *
+ * - `ping`     — `GET /ping` (constant route)
+ * - `echo`     — `POST /bench/echo` with a JSON body of `--payload` bytes, parsed and re-serialized
+ * - `download` — `GET /bench/download?size=<payload>`, a streamed `application/octet-stream` body
+ * - `upload`   — `POST /bench/upload` with `--payload` bytes, taken piece by piece with `receive_body`
+ *
+ * One JSON object per scenario is printed to stdout (JSON Lines), e.g.
+ * @code
+ * {"scenario":"ping","connections":64,"keep_alive":true,"payload":0,"seconds":5.0,"requests":812345,
+ *  "errors":0,"rps":162469.0,"mb_per_s":41.2,"latency_us":{"p50":310,"p99":820,"p999":1900,"max":5230}}
+ * @endcode
+ *
+ * For `upload`, `mb_per_s` counts the request bodies sent; otherwise the responses received.
+ *
+ * Options: `--scenario ping|echo|download|upload|broadcast|all`, `--connections N`, `--keep-alive 0|1`,
+ * `--payload BYTES`, `--duration SECONDS`, `--server-threads N` (0 = hardware concurrency),
+ * `--rate N` (`broadcast` only).
+ *
+ * Built with `ENABLE_TLS`, the server speaks HTTPS with a self-signed P-256 certificate generated
+ * at startup, every client connection is TLS, and two more knobs apply:
+ *
+ * - `handshake` — a new connection per `GET /ping` (`Connection: close`), so the rate is bounded
+ *   by TCP setup plus the TLS handshake; not part of `all`
+ * - `--resume 0|1` — offer the session from the client's previous connection (ticket or session
+ *   id), so reconnects take the abbreviated handshake; the output gains a `"resumed"` count
+ *
+ * Built with `ENABLE_HTTP2`, `--protocol h2` runs the scenarios over HTTP/2 instead (prior
+ * knowledge in plaintext, ALPN under TLS): each of the `--connections` connections keeps
+ * `--streams N` requests in flight, replacing every finished stream with a new one. Comparing
+ * `--protocol h1 --connections 64` with `--protocol h2 --connections 4 --streams 16` shows what
+ * multiplexing buys for many small concurrent requests. Over HTTP/2, `mb_per_s` counts bodies only.
+ *
+ * `broadcast` (not part of `all`) measures WebSocket fan-out instead: `--connections` clients
+ * subscribe to one topic through `bench/ws`, and the benchmark publishes `--rate` messages per
+ * second (0 = as fast as it can) of `--payload` bytes to it from inside the process. Each message
+ * carries its publish time, so `latency_us` is publish-to-receive; `delivered` counts messages
+ * received over all clients, and `slow_closed`/`dropped` report what backpressure did to clients
+ * that could not keep up.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef ENABLE_TLS
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <cstdlib>
+#include "../Web/tls.hpp"
+#endif
+#ifdef ENABLE_HTTP2
+#include <nghttp2/nghttp2.h>
+#include <unordered_map>
+#endif
+#include <boost/asio/ip/tcp.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "../Web/views.hpp"
+#include "../Web/bulgogi.hpp"
+
+using tcp = boost::asio::ip::tcp;
+
+int run_server(const tcp::endpoint &endpoint, unsigned threads, const std::function<void(unsigned short)> &on_listening);
+void stop_server();
+
+// Bench routes are added from main() rather than with the REGISTER_* macros: their registrars
+// would run during static initialisation of this translation unit, and nothing orders that after
+// the construction of the route maps in Web/views.cpp.
+
+void bench_echo(const bulgogi::Request &req, bulgogi::Response &res, const bulgogi::remote_address &) {
+    if (!bulgogi::check_method(req, bulgogi::http::verb::post, res)) return;
+    const auto doc = bulgogi::get_json_doc(req);
+    bulgogi::set_json(res, doc.value());
+}
+
+void bench_download(const bulgogi::Request &req, bulgogi::Response &res, const bulgogi::remote_address &) {
+    if (!bulgogi::check_method(req, bulgogi::http::verb::get, res)) return;
+    const auto size = std::stoull(bulgogi::get_query_param(req, "size").value_or("1048576"));
+    auto left = std::make_shared<std::uint64_t>(size);
+    bulgogi::set_binary(res, [left](char *buffer, std::size_t capacity) {
+        const auto n = static_cast<std::size_t>(std::min<std::uint64_t>(*left, capacity));
+        std::memset(buffer, 'x', n);
+        *left -= n;
+        return n;
+    }, "bench.bin", size);
+}
+
+void bench_upload(const bulgogi::Request &req, bulgogi::Response &res, const bulgogi::remote_address &) {
+    if (!bulgogi::check_method(req, bulgogi::http::verb::post, res)) return;
+    auto received = std::make_shared<std::uint64_t>(0);
+    bulgogi::receive_body([received](std::string_view piece) { *received += piece.size(); },
+                          [received](bulgogi::Response &res) { bulgogi::set_json(res, {{"received", *received}}); });
+}
+
+void bench_feed(const bulgogi::Request &, bulgogi::websocket::upgrade &ws, const bulgogi::remote_address &) {
+    ws.topics.emplace_back("bench");
+}
+
+/// @brief Add the bench routes; called before `run_server` freezes the route maps.
+void register_bench_routes() {
+    views::function_map["bench/echo"] = bench_echo;
+    views::body_map["bench/echo"] = views::body_rule{1ull << 30, false};
+    views::function_map["bench/download"] = bench_download;
+    views::function_map["bench/upload"] = bench_upload;
+    views::body_map["bench/upload"] = views::body_rule{bulgogi::unlimited_body, true};
+    views::websocket_map.emplace_back("bench/ws", bench_feed);
+}
+
+namespace {
+
+    struct options {
+        std::string scenario = "all";
+        unsigned connections = 64;
+        bool keep_alive = true;
+        std::size_t payload = 1024;
+        double duration = 5;
+        unsigned server_threads = 0;
+        bool resume = true;
+        bool http2 = false;
+        unsigned streams = 16;
+        unsigned rate = 1000;
+    };
+
+    struct result {
+        std::vector<std::uint32_t> latency_us;
+        std::uint64_t errors = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t resumed = 0;
+    };
+
+#ifdef ENABLE_TLS
+    /// @brief Client context: no certificate verification, the server's certificate is self-signed.
+    SSL_CTX *client_context() {
+        static SSL_CTX *ctx = [] {
+            SSL_CTX *c = SSL_CTX_new(TLS_client_method());
+            SSL_CTX_set_min_proto_version(c, TLS1_2_VERSION);
+            SSL_CTX_set_verify(c, SSL_VERIFY_NONE, nullptr);
+            SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_OFF);  // sessions are kept per client
+            return c;
+        }();
+        return ctx;
+    }
+
+    /// @brief Write a fresh self-signed `CN=localhost` P-256 certificate and key to temp files.
+    bool make_self_signed(bulgogi::tls::options &out) {
+        EVP_PKEY *key = EVP_EC_gen("P-256");
+        X509 *cert = X509_new();
+        bool ok = key && cert;
+        if (ok) {
+            ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+            X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+            X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 3600);
+            X509_set_pubkey(cert, key);
+            X509_NAME *name = X509_get_subject_name(cert);
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                       reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+            X509_set_issuer_name(cert, name);
+            ok = X509_sign(cert, key, EVP_sha256()) > 0;
+        }
+
+        const auto write = [](std::string &path, const std::function<int(FILE *)> &pem) {
+            char name[] = "/tmp/bulgogi_bench_XXXXXX";
+            const int fd = ::mkstemp(name);
+            if (fd < 0) return false;
+            FILE *file = ::fdopen(fd, "w");
+            const bool written = file && pem(file) == 1;
+            if (file) std::fclose(file);
+            path = name;
+            return written;
+        };
+        ok = ok && write(out.certificate, [&](FILE *f) { return PEM_write_X509(f, cert); }) &&
+             write(out.private_key, [&](FILE *f) {
+                 return PEM_write_PrivateKey(f, key, nullptr, nullptr, 0, nullptr, nullptr);
+             });
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        return ok;
+    }
+#endif
+
+    /// @brief A blocking loopback TCP connection, wrapped in TLS under `ENABLE_TLS`.
+    class transport {
+        unsigned short port_;
+        int fd_ = -1;
+#ifdef ENABLE_TLS
+        bool resume_;
+        SSL *ssl_ = nullptr;
+        SSL_SESSION *session_ = nullptr;
+#endif
+
+    public:
+        std::uint64_t resumed = 0;  ///< Handshakes the server accepted as resumptions
+
+        explicit transport(unsigned short port, [[maybe_unused]] bool resume = true) : port_(port) {
+#ifdef ENABLE_TLS
+            resume_ = resume;
+#endif
+        }
+
+        ~transport() {
+            disconnect();
+#ifdef ENABLE_TLS
+            if (session_) SSL_SESSION_free(session_);
+#endif
+        }
+
+        transport(const transport &) = delete;
+        transport &operator=(const transport &) = delete;
+
+        [[nodiscard]] bool connected() const noexcept { return fd_ >= 0; }
+
+        void disconnect() {
+#ifdef ENABLE_TLS
+            if (ssl_) {
+                // Keep the session (and any ticket received with the last response) for the next connect
+                if (resume_ && SSL_is_init_finished(ssl_)) {
+                    if (session_) SSL_SESSION_free(session_);
+                    session_ = SSL_get1_session(ssl_);
+                }
+                SSL_shutdown(ssl_);  // without close_notify OpenSSL marks the session not resumable
+                SSL_free(ssl_);
+                ssl_ = nullptr;
+            }
+#endif
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = -1;
+        }
+
+        /// @param h2 Offer `h2` through ALPN (TLS only; plaintext HTTP/2 is prior knowledge).
+        bool connect([[maybe_unused]] bool h2 = false) {
+            fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (fd_ < 0) return false;
+            const int one = 1;
+            ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port_);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (::connect(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+                disconnect();
+                return false;
+            }
+#ifdef ENABLE_TLS
+            ssl_ = SSL_new(client_context());
+            SSL_set_fd(ssl_, fd_);
+            if (h2) SSL_set_alpn_protos(ssl_, reinterpret_cast<const unsigned char *>("\x02h2"), 3);
+            if (resume_ && session_) SSL_set_session(ssl_, session_);
+            if (SSL_connect(ssl_) != 1) {
+                disconnect();
+                return false;
+            }
+            if (SSL_session_reused(ssl_)) ++resumed;
+#endif
+            return true;
+        }
+
+        bool write_all(std::string_view data) {
+            while (!data.empty()) {
+#ifdef ENABLE_TLS
+                const long n = SSL_write(ssl_, data.data(), static_cast<int>(std::min<std::size_t>(data.size(), 1 << 30)));
+#else
+                const long n = ::send(fd_, data.data(), data.size(), MSG_NOSIGNAL);
+#endif
+                if (n <= 0) return false;
+                data.remove_prefix(static_cast<std::size_t>(n));
+            }
+            return true;
+        }
+
+        /// @return Bytes read into @p buffer, 0 or less when the connection is gone.
+        long read_some(char *buffer, std::size_t capacity) {
+#ifdef ENABLE_TLS
+            return SSL_read(ssl_, buffer, static_cast<int>(capacity));
+#else
+            return ::recv(fd_, buffer, capacity, 0);
+#endif
+        }
+    };
+
+    /// @brief One blocking HTTP/1.1 client connection; reconnects whenever the server closes.
+    class client {
+        transport conn_;
+        std::string buffer_;
+
+    public:
+        explicit client(unsigned short port, bool resume = true) : conn_(port, resume) { buffer_.reserve(1 << 16); }
+
+        [[nodiscard]] std::uint64_t resumed() const noexcept { return conn_.resumed; }
+
+        /**
+         * @brief Send @p request and read the whole response.
+         * @return Response size in bytes, or 0 on any failure or non-2xx status.
+         */
+        std::size_t round_trip(std::string_view request) {
+            if (!conn_.connected() && !conn_.connect()) return 0;
+            if (!conn_.write_all(request)) return fail();
+
+            buffer_.clear();
+            std::size_t header_end;
+            while ((header_end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+                if (!read_more()) return fail();
+            }
+            header_end += 4;
+            const std::string_view head(buffer_.data(), header_end);
+
+            std::size_t length = 0;
+            if (const auto at = find_header(head, "content-length:"); at != std::string_view::npos) {
+                std::size_t i = at;
+                while (i < head.size() && head[i] == ' ') ++i;
+                std::from_chars(head.data() + i, head.data() + head.size(), length);
+            }
+            const bool close = find_header(head, "connection: close") != std::string_view::npos;
+            const bool ok = head.size() > 9 && head[9] == '2';
+
+            // Count the body without keeping it: large downloads would otherwise grow the buffer
+            std::size_t body = buffer_.size() - header_end;
+            while (body < length) {
+                buffer_.clear();
+                if (!read_more()) return fail();
+                body += buffer_.size();
+            }
+            if (close) conn_.disconnect();
+            return ok ? header_end + length : 0;
+        }
+
+    private:
+        std::size_t fail() {
+            conn_.disconnect();
+            return 0;
+        }
+
+        bool read_more() {
+            char chunk[1 << 16];
+            const auto n = conn_.read_some(chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            buffer_.append(chunk, static_cast<std::size_t>(n));
+            return true;
+        }
+
+        /// @brief Position right after @p needle (lower case) in @p head, case-insensitively.
+        static std::size_t find_header(std::string_view head, std::string_view needle) {
+            for (std::size_t i = 0; i + needle.size() <= head.size(); ++i) {
+                std::size_t k = 0;
+                while (k < needle.size() && std::tolower(static_cast<unsigned char>(head[i + k])) == needle[k]) ++k;
+                if (k == needle.size()) return i + k;
+            }
+            return std::string_view::npos;
+        }
+    };
+
+    /// @brief One blocking `bench/ws` WebSocket client that only reads.
+    class subscriber {
+        transport conn_;
+        std::string buffer_;
+        std::size_t pos_ = 0;  // start of unread bytes in buffer_
+
+    public:
+        explicit subscriber(unsigned short port) : conn_(port) { buffer_.reserve(1 << 16); }
+
+        /// @brief Connect and complete the upgrade; @return false unless the server answered `101`.
+        bool open() {
+            static constexpr std::string_view upgrade =
+                    "GET /bench/ws HTTP/1.1\r\nHost: bench\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+            if (!conn_.connect() || !conn_.write_all(upgrade)) return false;
+            std::size_t header_end;
+            while ((header_end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+                if (!read_more()) return false;
+            }
+            pos_ = header_end + 4;
+            return buffer_.size() > 12 && buffer_.compare(9, 3, "101") == 0;
+        }
+
+        /**
+         * @brief Read the next data frame.
+         * @param stamp Set to the first 8 payload bytes (the publish time).
+         * @return Payload size, or -1 once the server closed the connection.
+         */
+        long next(std::uint64_t &stamp) {
+            while (true) {
+                if (!need(2)) return -1;
+                const auto *head = reinterpret_cast<const unsigned char *>(buffer_.data() + pos_);
+                const unsigned opcode = head[0] & 0x0f;
+                std::uint64_t length = head[1] & 0x7f;
+                std::size_t offset = 2;
+                if (length == 126) offset = 4;
+                else if (length == 127) offset = 10;
+                if (!need(offset)) return -1;
+                head = reinterpret_cast<const unsigned char *>(buffer_.data() + pos_);
+                if (offset > 2) {
+                    length = 0;
+                    for (std::size_t i = 2; i < offset; ++i) length = length << 8 | head[i];
+                }
+                if (!need(offset + length)) return -1;
+                const char *payload = buffer_.data() + pos_ + offset;
+                pos_ += offset + length;
+                if (opcode == 0x8) return -1;                // close
+                if (opcode != 0x1 && opcode != 0x2) continue;  // ping, pong, continuation
+                stamp = 0;
+                if (length >= sizeof(stamp)) std::memcpy(&stamp, payload, sizeof(stamp));
+                return static_cast<long>(length);
+            }
+        }
+
+    private:
+        bool need(std::size_t n) {
+            while (buffer_.size() - pos_ < n) {
+                // Keep the buffer from growing with every frame read
+                if (pos_ > 0) {
+                    buffer_.erase(0, pos_);
+                    pos_ = 0;
+                }
+                if (!read_more()) return false;
+            }
+            return true;
+        }
+
+        bool read_more() {
+            char chunk[1 << 16];
+            const auto n = conn_.read_some(chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            buffer_.append(chunk, static_cast<std::size_t>(n));
+            return true;
+        }
+    };
+
+#ifdef ENABLE_HTTP2
+    /// @brief A scenario's request in HTTP/2 terms.
+    struct h2_request {
+        std::string method;
+        std::string path;
+        std::string content_type;
+        std::string body;
+    };
+
+    /**
+     * @brief One blocking HTTP/2 client connection that keeps `streams` requests in flight.
+     *
+     * Each finished stream is recorded and immediately replaced by a new one until the deadline;
+     * the connection is then drained. Latency is measured per stream, from submission to close.
+     */
+    class h2_client {
+        using clock = std::chrono::steady_clock;
+
+        struct in_flight {
+            clock::time_point start;
+            std::size_t offset = 0;  // request body bytes handed to nghttp2
+            std::size_t bytes = 0;   // response body bytes received
+            bool ok = false;
+        };
+
+        transport conn_;
+        const h2_request &request_;
+        unsigned streams_;
+        bool count_request_;
+        nghttp2_session *session_ = nullptr;
+        std::unordered_map<std::int32_t, in_flight> in_flight_;
+        result *result_ = nullptr;
+        clock::time_point deadline_;
+
+    public:
+        /// @param count_request Count request bodies instead of response bodies as throughput.
+        h2_client(unsigned short port, bool resume, const h2_request &request, unsigned streams, bool count_request)
+                : conn_(port, resume), request_(request), streams_(streams), count_request_(count_request) {}
+
+        h2_client(const h2_client &) = delete;
+        h2_client &operator=(const h2_client &) = delete;
+
+        [[nodiscard]] std::uint64_t resumed() const noexcept { return conn_.resumed; }
+
+        /// @brief Open a connection and drive it until @p deadline, recording into @p r.
+        void run(clock::time_point deadline, result &r) {
+            result_ = &r;
+            deadline_ = deadline;
+            if (!conn_.connect(true) || !start()) {
+                ++r.errors;
+                conn_.disconnect();
+                return;
+            }
+            for (unsigned i = 0; i < streams_; ++i) submit();
+
+            char chunk[1 << 16];
+            while (flush() && !in_flight_.empty()) {
+                const auto n = conn_.read_some(chunk, sizeof(chunk));
+                if (n <= 0 || nghttp2_session_mem_recv(session_, reinterpret_cast<const std::uint8_t *>(chunk),
+                                                       static_cast<std::size_t>(n)) < 0) {
+                    break;
+                }
+            }
+            r.errors += in_flight_.size();  // lost with the connection
+            in_flight_.clear();
+            nghttp2_session_del(session_);
+            session_ = nullptr;
+            conn_.disconnect();
+        }
+
+    private:
+        bool start() {
+            nghttp2_session_callbacks *callbacks = nullptr;
+            nghttp2_session_callbacks_new(&callbacks);
+            nghttp2_session_callbacks_set_on_header_callback(callbacks, &h2_client::on_header);
+            nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, &h2_client::on_data);
+            nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, &h2_client::on_close);
+            const int rv = nghttp2_session_client_new(&session_, callbacks, this);
+            nghttp2_session_callbacks_del(callbacks);
+            if (rv != 0) return false;
+
+            // Generous receive windows, so downloads are not throttled by the client side
+            const nghttp2_settings_entry settings[] = {{NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, 1 << 24}};
+            nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, settings, 1);
+            nghttp2_session_set_local_window_size(session_, NGHTTP2_FLAG_NONE, 0, 1 << 30);
+            return true;
+        }
+
+        void submit() {
+            const auto nv = [](std::string_view name, std::string_view value) {
+                return nghttp2_nv{reinterpret_cast<std::uint8_t *>(const_cast<char *>(name.data())),
+                                  reinterpret_cast<std::uint8_t *>(const_cast<char *>(value.data())),
+                                  name.size(), value.size(), NGHTTP2_NV_FLAG_NONE};
+            };
+#ifdef ENABLE_TLS
+            constexpr std::string_view scheme = "https";
+#else
+            constexpr std::string_view scheme = "http";
+#endif
+            const std::string length = std::to_string(request_.body.size());
+            std::vector<nghttp2_nv> headers{nv(":method", request_.method), nv(":path", request_.path),
+                                            nv(":scheme", scheme), nv(":authority", "bench")};
+            nghttp2_data_provider provider{};
+            provider.source.ptr = this;
+            provider.read_callback = &h2_client::read_body;
+            if (!request_.body.empty()) {
+                headers.push_back(nv("content-type", request_.content_type));
+                headers.push_back(nv("content-length", length));
+            }
+            const auto id = nghttp2_submit_request(session_, nullptr, headers.data(), headers.size(),
+                                                   request_.body.empty() ? nullptr : &provider, nullptr);
+            if (id > 0) in_flight_[id].start = clock::now();
+        }
+
+        /// @brief Write everything nghttp2 has queued.
+        bool flush() {
+            while (true) {
+                const std::uint8_t *data = nullptr;
+                const auto n = nghttp2_session_mem_send(session_, &data);
+                if (n < 0) return false;
+                if (n == 0) return true;
+                if (!conn_.write_all({reinterpret_cast<const char *>(data), static_cast<std::size_t>(n)})) return false;
+            }
+        }
+
+        static int on_header(nghttp2_session *, const nghttp2_frame *frame, const std::uint8_t *name,
+                             std::size_t name_length, const std::uint8_t *value, std::size_t, std::uint8_t, void *user) {
+            auto &self = *static_cast<h2_client *>(user);
+            const std::string_view field(reinterpret_cast<const char *>(name), name_length);
+            if (field == ":status") {
+                const auto it = self.in_flight_.find(frame->hd.stream_id);
+                if (it != self.in_flight_.end()) it->second.ok = value[0] == '2';
+            }
+            return 0;
+        }
+
+        static int on_data(nghttp2_session *, std::uint8_t, std::int32_t id, const std::uint8_t *, std::size_t length,
+                           void *user) {
+            auto &self = *static_cast<h2_client *>(user);
+            const auto it = self.in_flight_.find(id);
+            if (it != self.in_flight_.end()) it->second.bytes += length;
+            return 0;
+        }
+
+        static int on_close(nghttp2_session *, std::int32_t id, std::uint32_t error, void *user) {
+            auto &self = *static_cast<h2_client *>(user);
+            const auto it = self.in_flight_.find(id);
+            if (it == self.in_flight_.end()) return 0;
+            const auto now = clock::now();
+            auto &r = *self.result_;
+            if (error == NGHTTP2_NO_ERROR && it->second.ok) {
+                r.bytes += self.count_request_ ? self.request_.body.size() : it->second.bytes;
+                r.latency_us.push_back(static_cast<std::uint32_t>(
+                        std::chrono::duration_cast<std::chrono::microseconds>(now - it->second.start).count()));
+            } else {
+                ++r.errors;
+            }
+            self.in_flight_.erase(it);
+            if (now < self.deadline_) self.submit();
+            return 0;
+        }
+
+        static ssize_t read_body(nghttp2_session *, std::int32_t id, std::uint8_t *buffer, std::size_t length,
+                                 std::uint32_t *flags, nghttp2_data_source *, void *user) {
+            auto &self = *static_cast<h2_client *>(user);
+            auto &offset = self.in_flight_[id].offset;
+            const auto &body = self.request_.body;
+            const auto n = std::min(length, body.size() - offset);
+            std::memcpy(buffer, body.data() + offset, n);
+            offset += n;
+            if (offset == body.size()) *flags |= NGHTTP2_DATA_FLAG_EOF;
+            return static_cast<ssize_t>(n);
+        }
+    };
+#endif
+
+    /// @brief `{"data":"xxx..."}` padded to the requested payload size.
+    std::string echo_body(const options &opt) {
+        const std::size_t overhead = 11;
+        return R"({"data":")" + std::string(opt.payload > overhead ? opt.payload - overhead : 0, 'x') + R"("})";
+    }
+
+    std::string build_request(std::string_view scenario, const options &opt) {
+        const std::string connection = opt.keep_alive && scenario != "handshake" ? "" : "Connection: close\r\n";
+        if (scenario == "ping" || scenario == "handshake") {
+            return "GET /ping HTTP/1.1\r\nHost: bench\r\n" + connection + "\r\n";
+        }
+        if (scenario == "echo") {
+            const std::string body = echo_body(opt);
+            return "POST /bench/echo HTTP/1.1\r\nHost: bench\r\nContent-Type: application/json\r\nContent-Length: " +
+                   std::to_string(body.size()) + "\r\n" + connection + "\r\n" + body;
+        }
+        if (scenario == "upload") {
+            return "POST /bench/upload HTTP/1.1\r\nHost: bench\r\nContent-Type: application/octet-stream\r\n"
+                   "Content-Length: " + std::to_string(opt.payload) + "\r\n" + connection + "\r\n" +
+                   std::string(opt.payload, 'x');
+        }
+        return "GET /bench/download?size=" + std::to_string(opt.payload) + " HTTP/1.1\r\nHost: bench\r\n" +
+               connection + "\r\n";
+    }
+
+#ifdef ENABLE_HTTP2
+    h2_request build_h2_request(std::string_view scenario, const options &opt) {
+        if (scenario == "echo") return {"POST", "/bench/echo", "application/json", echo_body(opt)};
+        if (scenario == "upload") {
+            return {"POST", "/bench/upload", "application/octet-stream", std::string(opt.payload, 'x')};
+        }
+        if (scenario == "download") return {"GET", "/bench/download?size=" + std::to_string(opt.payload), "", ""};
+        return {"GET", "/ping", "", ""};
+    }
+#endif
+
+    std::uint32_t percentile(const std::vector<std::uint32_t> &sorted, double p) {
+        if (sorted.empty()) return 0;
+        const auto i = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+        return sorted[i];
+    }
+
+    void run_scenario(std::string_view scenario, const options &opt, unsigned short port) {
+        const std::string request = build_request(scenario, opt);
+        std::vector<result> results(opt.connections);
+        std::atomic<bool> go{false};
+        const auto duration = std::chrono::duration<double>(opt.duration);
+
+        std::vector<std::thread> threads;
+        threads.reserve(opt.connections);
+#ifdef ENABLE_HTTP2
+        const h2_request stream_request = build_h2_request(scenario, opt);
+        if (opt.http2) {
+            for (unsigned c = 0; c < opt.connections; ++c) {
+                threads.emplace_back([&, c] {
+                    h2_client cl(port, opt.resume, stream_request, opt.streams, scenario == "upload");
+                    auto &r = results[c];
+                    r.latency_us.reserve(1 << 16);
+                    while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                    const auto deadline = std::chrono::steady_clock::now() +
+                                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration);
+                    while (std::chrono::steady_clock::now() < deadline) cl.run(deadline, r);
+                    r.resumed = cl.resumed();
+                });
+            }
+        }
+#endif
+        for (unsigned c = 0; c < opt.connections && !opt.http2; ++c) {
+            threads.emplace_back([&, c] {
+                client cl(port, opt.resume);
+                auto &r = results[c];
+                r.latency_us.reserve(1 << 16);
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                const auto deadline = std::chrono::steady_clock::now() + duration;
+                while (true) {
+                    const auto start = std::chrono::steady_clock::now();
+                    if (start >= deadline) break;
+                    const std::size_t bytes = cl.round_trip(request);
+                    const auto elapsed = std::chrono::steady_clock::now() - start;
+                    if (bytes == 0) {
+                        ++r.errors;
+                        continue;
+                    }
+                    r.bytes += scenario == "upload" ? request.size() : bytes;
+                    r.latency_us.push_back(static_cast<std::uint32_t>(
+                            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+                }
+                r.resumed = cl.resumed();
+            });
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &t: threads) t.join();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        std::vector<std::uint32_t> latency;
+        std::uint64_t errors = 0, bytes = 0, resumed = 0;
+        for (auto &r: results) {
+            latency.insert(latency.end(), r.latency_us.begin(), r.latency_us.end());
+            errors += r.errors;
+            bytes += r.bytes;
+            resumed += r.resumed;
+        }
+        std::sort(latency.begin(), latency.end());
+
+        std::string extra;
+#ifdef ENABLE_TLS
+        extra = ",\"resumed\":" + std::to_string(resumed);
+#else
+        (void) resumed;
+#endif
+#ifdef ENABLE_HTTP2
+        extra += opt.http2 ? ",\"protocol\":\"h2\",\"streams\":" + std::to_string(opt.streams) : ",\"protocol\":\"h1\"";
+#endif
+
+        std::printf("{\"scenario\":\"%.*s\",\"connections\":%u,\"keep_alive\":%s,\"payload\":%zu,\"seconds\":%.3f,"
+                    "\"requests\":%zu,\"errors\":%llu,\"rps\":%.1f,\"mb_per_s\":%.2f,"
+                    "\"latency_us\":{\"p50\":%u,\"p99\":%u,\"p999\":%u,\"max\":%u}%s}\n",
+                    static_cast<int>(scenario.size()), scenario.data(), opt.connections,
+                    opt.keep_alive && scenario != "handshake" ? "true" : "false",
+                    scenario == "ping" || scenario == "handshake" ? std::size_t(0) : opt.payload, seconds,
+                    latency.size(), static_cast<unsigned long long>(errors),
+                    static_cast<double>(latency.size()) / seconds, static_cast<double>(bytes) / seconds / 1e6,
+                    percentile(latency, 0.50), percentile(latency, 0.99), percentile(latency, 0.999),
+                    latency.empty() ? 0u : latency.back(), extra.c_str());
+        std::fflush(stdout);
+    }
+
+    std::uint64_t now_ns() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /// @brief WebSocket fan-out: subscribers on `bench/ws`, messages published in-process.
+    void run_broadcast(const options &opt, unsigned short port) {
+        std::vector<result> results(opt.connections);
+        std::atomic<unsigned> opened{0}, settled{0};
+        std::atomic<bool> done{false};
+
+        std::vector<std::thread> threads;
+        threads.reserve(opt.connections);
+        for (unsigned c = 0; c < opt.connections; ++c) {
+            threads.emplace_back([&, c] {
+                subscriber sub(port);
+                auto &r = results[c];
+                r.latency_us.reserve(1 << 16);
+                const bool ok = sub.open();
+                if (ok) opened.fetch_add(1);
+                else ++r.errors;
+                settled.fetch_add(1);
+                if (!ok) return;
+                std::uint64_t stamp = 0;
+                for (long n; (n = sub.next(stamp)) >= 0;) {
+                    r.bytes += static_cast<std::uint64_t>(n);
+                    r.latency_us.push_back(static_cast<std::uint32_t>((now_ns() - stamp) / 1000));
+                }
+                if (!done.load()) ++r.errors;  // closed by the server before the end: too slow
+            });
+        }
+
+        // Subscriptions are made once the handshake is written, just after the client sees it
+        while (settled.load() < opt.connections) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        const auto wait_until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (bulgogi::websocket::subscribers("bench") < opened.load() && std::chrono::steady_clock::now() < wait_until) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        const auto slow_before = bulgogi::websocket::slow_closed();
+        const auto dropped_before = bulgogi::websocket::dropped();
+        std::string payload(std::max<std::size_t>(opt.payload, sizeof(std::uint64_t)), 'x');
+        std::uint64_t published = 0;
+        const auto started = std::chrono::steady_clock::now();
+        const auto deadline = started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(opt.duration));
+        const auto interval = std::chrono::nanoseconds(opt.rate ? 1'000'000'000ull / opt.rate : 0);
+        auto next = started;
+        while (std::chrono::steady_clock::now() < deadline) {
+            const std::uint64_t stamp = now_ns();
+            std::memcpy(payload.data(), &stamp, sizeof(stamp));
+            bulgogi::websocket::publish("bench", bulgogi::websocket::make_binary(payload));
+            ++published;
+            if (opt.rate) std::this_thread::sleep_until(next += interval);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        // Let the queues drain, then end the subscribers
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        done.store(true);
+        bulgogi::websocket::close_all(bulgogi::websocket::normal);
+        for (auto &t: threads) t.join();
+
+        std::vector<std::uint32_t> latency;
+        std::uint64_t errors = 0, bytes = 0;
+        for (auto &r: results) {
+            latency.insert(latency.end(), r.latency_us.begin(), r.latency_us.end());
+            errors += r.errors;
+            bytes += r.bytes;
+        }
+        std::sort(latency.begin(), latency.end());
+
+        std::printf("{\"scenario\":\"broadcast\",\"connections\":%u,\"payload\":%zu,\"rate\":%u,\"seconds\":%.3f,"
+                    "\"published\":%llu,\"delivered\":%zu,\"errors\":%llu,\"deliveries_per_s\":%.1f,\"mb_per_s\":%.2f,"
+                    "\"latency_us\":{\"p50\":%u,\"p99\":%u,\"p999\":%u,\"max\":%u},\"slow_closed\":%llu,\"dropped\":%llu}\n",
+                    opt.connections, payload.size(), opt.rate, seconds, static_cast<unsigned long long>(published),
+                    latency.size(), static_cast<unsigned long long>(errors),
+                    static_cast<double>(latency.size()) / seconds, static_cast<double>(bytes) / seconds / 1e6,
+                    percentile(latency, 0.50), percentile(latency, 0.99), percentile(latency, 0.999),
+                    latency.empty() ? 0u : latency.back(),
+                    static_cast<unsigned long long>(bulgogi::websocket::slow_closed() - slow_before),
+                    static_cast<unsigned long long>(bulgogi::websocket::dropped() - dropped_before));
+        std::fflush(stdout);
+    }
+
+    bool parse_args(int argc, char **argv, options &opt) {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            const std::string_view key = argv[i];
+            const std::string value = argv[i + 1];
+            if (key == "--scenario") opt.scenario = value;
+            else if (key == "--connections") opt.connections = static_cast<unsigned>(std::stoul(value));
+            else if (key == "--keep-alive") opt.keep_alive = value != "0" && value != "false";
+            else if (key == "--payload") opt.payload = std::stoull(value);
+            else if (key == "--duration") opt.duration = std::stod(value);
+            else if (key == "--server-threads") opt.server_threads = static_cast<unsigned>(std::stoul(value));
+            else if (key == "--rate") opt.rate = static_cast<unsigned>(std::stoul(value));
+#ifdef ENABLE_TLS
+            else if (key == "--resume") opt.resume = value != "0" && value != "false";
+#endif
+#ifdef ENABLE_HTTP2
+            else if (key == "--protocol" && (value == "h1" || value == "h2")) opt.http2 = value == "h2";
+            else if (key == "--streams") opt.streams = static_cast<unsigned>(std::stoul(value));
+#endif
+            else return false;
+        }
+        return argc % 2 == 1 && opt.connections > 0 && opt.streams > 0 && !(opt.http2 && opt.scenario == "handshake") &&
+               (opt.scenario == "all" || opt.scenario == "ping" || opt.scenario == "echo" ||
+                opt.scenario == "download" || opt.scenario == "upload" ||
+                (opt.scenario == "broadcast" && !opt.http2)
+#ifdef ENABLE_TLS
+                || opt.scenario == "handshake"
+#endif
+               );
+    }
+}
+
+int main(int argc, char **argv) {
+    options opt;
+    try {
+        if (!parse_args(argc, argv, opt)) throw std::invalid_argument("bad arguments");
+    } catch (const std::exception &) {
+        std::cerr << "usage: bulgogi_bench [--scenario ping|echo|download|upload|broadcast"
+#ifdef ENABLE_TLS
+                     "|handshake"
+#endif
+                     "|all] [--connections N] [--keep-alive 0|1] [--payload BYTES] [--duration SECONDS] "
+                     "[--server-threads N] [--rate N]"
+#ifdef ENABLE_TLS
+                     " [--resume 0|1]"
+#endif
+#ifdef ENABLE_HTTP2
+                     " [--protocol h1|h2] [--streams N]"
+#endif
+                     "\n";
+        return 2;
+    }
+
+#ifdef ENABLE_TLS
+    if (!make_self_signed(bulgogi::tls::settings())) {
+        std::cerr << "could not create a self-signed certificate\n";
+        return 1;
+    }
+#endif
+
+    register_bench_routes();
+
+    std::promise<unsigned short> listening;
+    auto port_future = listening.get_future();
+    std::thread server([&] {
+        bool ready = false;
+        const int rc = run_server(tcp::endpoint{boost::asio::ip::address_v4::loopback(), 0}, opt.server_threads,
+                                  [&](unsigned short port) {
+                                      ready = true;
+                                      listening.set_value(port);
+                                  });
+        if (!ready) listening.set_value(0);
+        if (rc != 0) std::cerr << "server exited with " << rc << "\n";
+    });
+
+    const unsigned short port = port_future.get();
+    if (port != 0) {
+        for (const std::string_view scenario: {"ping", "echo", "download", "upload"}) {
+            if (opt.scenario == "all" || opt.scenario == scenario) run_scenario(scenario, opt, port);
+        }
+        if (opt.scenario == "handshake") run_scenario("handshake", opt, port);
+        if (opt.scenario == "broadcast") run_broadcast(opt, port);
+        stop_server();
+    }
+    server.join();
+#ifdef ENABLE_TLS
+    std::remove(bulgogi::tls::settings().certificate.c_str());
+    std::remove(bulgogi::tls::settings().private_key.c_str());
+#endif
+    return port != 0 ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+// bench/helpers_bench.cpp
+
+/**
+ * @file helpers_bench.cpp
+ * @brief Per-call cost of the inline helpers handlers run on every request.
+ *
+ * No sockets are involved: each benchmark calls one helper from `Web/bulgogi.hpp` (or
+ * `Web/cors.hpp` for comparison) on a prepared `bulgogi::Request` / `bulgogi::Response`.
+ *
+ * - `BM_SetJson/N`: `set_json` of an object with N 32-byte string members.
+ * - `BM_CheckMethod_*`: a same-origin request, a cross-origin one and a preflight, against the
+ *   verb-list overload and a pre-rendered `cors_policy`.
+ * - `BM_GetQueryParam/N`: the last of N query parameters, via `get_query_param` and `get_query`;
+ *   N=50 is past `QueryView::capacity`, so the view finds it by scanning the unparsed rest.
+ * - `BM_ApplyCors*`: the default headers and an explicit method list.
+ * - `BM_ParseIpv4Strict` / `BM_IsInternalNetwork`: valid and invalid addresses, from text.
+ * - `BM_IsInternalNetwork_Address`: the same addresses as handlers get them (`remote_address`).
+ * - `BM_CidrSetContains/N`: lookup in a set of N networks, half IPv4 and half IPv6.
+ * - `BM_TokenBucketAcquire/N`: a rate-limit check, cycling through N distinct IPv4 clients.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "../Web/bulgogi.hpp"
+#include "../Web/cors.hpp"
+#include "../Web/rate_limit.hpp"
+
+namespace {
+
+    namespace http = bulgogi::http;
+
+    bulgogi::Request make_request(http::verb method, std::string target, std::string_view origin = {}) {
+        bulgogi::Request req{method, target, 11};
+        req.set(http::field::host, "bench");
+        if (!origin.empty()) req.set(http::field::origin, origin);
+        return req;
+    }
+
+    void BM_SetJson(benchmark::State &state) {
+        boost::json::object obj;
+        for (std::int64_t i = 0; i < state.range(0); ++i) {
+            obj["field_" + std::to_string(i)] = std::string(32, 'v');
+        }
+        const boost::json::value value = std::move(obj);
+        for (auto _: state) {
+            bulgogi::Response res;
+            bulgogi::set_json(res, value);
+            benchmark::DoNotOptimize(res.body().data());
+            state.counters["bytes"] = static_cast<double>(res.body().size());
+        }
+    }
+
+    void BM_CheckMethod_SameOrigin(benchmark::State &state) {
+        const auto req = make_request(http::verb::get, "/api/user/info");
+        for (auto _: state) {
+            bulgogi::Response res;
+            benchmark::DoNotOptimize(bulgogi::check_method(req, {http::verb::get, http::verb::post}, res));
+        }
+    }
+
+    void BM_CheckMethod_Origin(benchmark::State &state) {
+        const auto req = make_request(http::verb::get, "/api/user/info", "https://app.example.com");
+        for (auto _: state) {
+            bulgogi::Response res;
+            benchmark::DoNotOptimize(bulgogi::check_method(req, {http::verb::get, http::verb::post}, res,
+                                                           "https://app.example.com", true));
+        }
+    }
+
+    void BM_CheckMethod_Preflight(benchmark::State &state) {
+        const auto req = make_request(http::verb::options, "/api/user/info", "https://app.example.com");
+        for (auto _: state) {
+            bulgogi::Response res;
+            benchmark::DoNotOptimize(bulgogi::check_method(req, {http::verb::get, http::verb::post}, res,
+                                                           "https://app.example.com", true));
+        }
+    }
+
+    const bulgogi::cors_policy &bench_policy() {
+        static const bulgogi::cors_policy policy{{http::verb::get, http::verb::post}, "https://app.example.com", true};
+        return policy;
+    }
+
+    void BM_CheckMethod_Policy_SameOrigin(benchmark::State &state) {
+        const auto req = make_request(http::verb::get, "/api/user/info");
+        for (auto _: state) {
+            bulgogi::Response res;
+            benchmark::DoNotOptimize(bulgogi::check_method(req, bench_policy(), res));
+        }
+    }
+
+    void BM_CheckMethod_Policy_Origin(benchmark::State &state) {
+        const auto req = make_request(http::verb::get, "/api/user/info", "https://app.example.com");
+        for (auto _: state) {
+            bulgogi::Response res;
+            benchmark::DoNotOptimize(bulgogi::check_method(req, bench_policy(), res));
+        }
+    }
+
+    std::string query_target(std::int64_t params) {
+        std::string target = "/search?";
+        for (std::int64_t i = 0; i < params; ++i) {
+            if (i) target += '&';
+            target += "key" + std::to_string(i) + "=value%20" + std::to_string(i);
+        }
+        return target;
+    }
+
+    void BM_GetQueryParam(benchmark::State &state) {
+        const auto req = make_request(http::verb::get, query_target(state.range(0)));
+        const std::string key = "key" + std::to_string(state.range(0) - 1);
+        if (!bulgogi::get_query_param(req, key)) {
+            state.SkipWithError("last query parameter not found");
+            return;
+        }
+        for (auto _: state) {
+            benchmark::DoNotOptimize(bulgogi::get_query_param(req, key));
+        }
+    }
+
+    void BM_GetQuery_View(benchmark::State &state) {
+        const auto req = make_request(http::verb::get, query_target(state.range(0)));
+        const std::string key = "key" + std::to_string(state.range(0) - 1);
+        if (!bulgogi::get_query(req).get(key)) {
+            state.SkipWithError("last query parameter not found");
+            return;
+        }
+        for (auto _: state) {
+            const auto query = bulgogi::get_query(req);
+            benchmark::DoNotOptimize(query.get(key));
+        }
+    }
+
+    void BM_ApplyCors(benchmark::State &state) {
+        for (auto _: state) {
+            bulgogi::Response res;
+            bulgogi::apply_cors(res);
+            benchmark::DoNotOptimize(res.begin());
+        }
+    }
+
+    void BM_ApplyCors_Methods(benchmark::State &state) {
+        for (auto _: state) {
+            bulgogi::Response res;
+            bulgogi::apply_cors(res, "https://app.example.com", {http::verb::get, http::verb::post, http::verb::put},
+                                true);
+            benchmark::DoNotOptimize(res.begin());
+        }
+    }
+
+    void BM_ApplyCors_Policy(benchmark::State &state) {
+        for (auto _: state) {
+            bulgogi::Response res;
+            bench_policy().apply(res);
+            benchmark::DoNotOptimize(res.begin());
+        }
+    }
+
+    const std::vector<std::string> &addresses() {
+        static const std::vector<std::string> list = {
+                "127.0.0.1", "192.168.10.20", "172.20.1.1", "10.0.0.254", "8.8.8.8", "300.1.1.1", "1.2.3", "::1"};
+        return list;
+    }
+
+    void BM_ParseIpv4Strict(benchmark::State &state) {
+        const auto &list = addresses();
+        std::size_t i = 0;
+        for (auto _: state) {
+            std::uint8_t a, b, c, d;
+            benchmark::DoNotOptimize(bulgogi::ipv4::detail::parse_ipv4_strict(list[i++ % list.size()], a, b, c, d));
+        }
+    }
+
+    void BM_IsInternalNetwork(benchmark::State &state) {
+        const auto &list = addresses();
+        std::size_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(bulgogi::ipv4::is_internal_network(list[i++ % list.size()]));
+        }
+    }
+
+    void BM_IsInternalNetwork_Address(benchmark::State &state) {
+        std::vector<bulgogi::remote_address> list;
+        for (const auto &text: addresses()) {
+            boost::system::error_code ec;
+            const auto address = boost::asio::ip::make_address(text, ec);
+            list.push_back(ec ? bulgogi::remote_address{} : bulgogi::remote_address{address});
+        }
+        std::size_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(bulgogi::ipv4::is_internal_network(list[i++ % list.size()]));
+        }
+    }
+
+    void BM_CidrSetContains(benchmark::State &state) {
+        bulgogi::cidr_set set;
+        for (std::int64_t i = 0; i < state.range(0) / 2; ++i) {
+            set.add(std::to_string(i % 224) + "." + std::to_string(i / 224 % 256) + ".0.0/16");
+            set.add("2001:db8:" + std::to_string(i) + "::/48");
+        }
+        const std::vector<boost::asio::ip::address> probes = {
+                boost::asio::ip::make_address("100.0.1.1"), boost::asio::ip::make_address("250.1.1.1"),
+                boost::asio::ip::make_address("2001:db8:7::1"), boost::asio::ip::make_address("2001:db9::1")};
+        std::size_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(set.contains(probes[i++ % probes.size()]));
+        }
+    }
+
+    void BM_TokenBucketAcquire(benchmark::State &state) {
+        bulgogi::rate_limit::token_buckets buckets{1e9, 1e9};  // never refuses, so every call does the full update
+        std::vector<bulgogi::rate_limit::client_key> clients;
+        for (std::int64_t i = 0; i < state.range(0); ++i) {
+            clients.emplace_back(boost::asio::ip::make_address_v4(static_cast<std::uint32_t>(0x0A000000 + i)));
+        }
+        std::size_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(buckets.acquire(clients[i++ % clients.size()]));
+        }
+    }
+}
+
+BENCHMARK(BM_SetJson)->Arg(1)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK(BM_CheckMethod_SameOrigin);
+BENCHMARK(BM_CheckMethod_Origin);
+BENCHMARK(BM_CheckMethod_Preflight);
+BENCHMARK(BM_CheckMethod_Policy_SameOrigin);
+BENCHMARK(BM_CheckMethod_Policy_Origin);
+BENCHMARK(BM_GetQueryParam)->Arg(1)->Arg(10)->Arg(50);
+BENCHMARK(BM_GetQuery_View)->Arg(1)->Arg(10)->Arg(50);
+BENCHMARK(BM_ApplyCors);
+BENCHMARK(BM_ApplyCors_Methods);
+BENCHMARK(BM_ApplyCors_Policy);
+BENCHMARK(BM_ParseIpv4Strict);
+BENCHMARK(BM_IsInternalNetwork);
+BENCHMARK(BM_IsInternalNetwork_Address);
+BENCHMARK(BM_CidrSetContains)->Arg(8)->Arg(128)->Arg(1024);
+BENCHMARK(BM_TokenBucketAcquire)->Arg(1)->Arg(1000)->Arg(100000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+// bench/json_writer_bench.cpp
+
+/**
+ * @file json_writer_bench.cpp
+ * @brief List-endpoint style JSON responses: `set_json(res, boost::json::value)` vs `json_writer`.
+ *
+ * Each iteration renders `{"rows":[{"id":..,"name":..,"score":..,"active":..}, ...]}` for N rows
+ * into a fresh `bulgogi::Response`, which is what a list handler does per request.
+ * The DOM variant builds a `boost::json::array` of objects first and then serializes it; the
+ * writer variant appends straight into `res.body()` after one reservation.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "../Web/bulgogi.hpp"
+
+namespace {
+
+    struct Row {
+        std::int64_t id;
+        std::string name;
+        double score;
+        bool active;
+    };
+
+    std::vector<Row> make_rows(std::size_t n) {
+        std::vector<Row> rows;
+        rows.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            rows.push_back({static_cast<std::int64_t>(i), "user \"" + std::to_string(i) + "\"", i * 0.5, i % 2 == 0});
+        }
+        return rows;
+    }
+
+    void BM_SetJson_Dom(benchmark::State &state) {
+        const auto rows = make_rows(static_cast<std::size_t>(state.range(0)));
+        for (auto _: state) {
+            bulgogi::Response res;
+            boost::json::array arr;
+            arr.reserve(rows.size());
+            for (const auto &r: rows) {
+                arr.push_back({{"id", r.id}, {"name", r.name}, {"score", r.score}, {"active", r.active}});
+            }
+            bulgogi::set_json(res, {{"rows", std::move(arr)}});
+            benchmark::DoNotOptimize(res.body().data());
+            state.counters["bytes"] = static_cast<double>(res.body().size());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_SetJson_Writer(benchmark::State &state) {
+        const auto rows = make_rows(static_cast<std::size_t>(state.range(0)));
+        for (auto _: state) {
+            bulgogi::Response res;
+            bulgogi::json_writer w(res.body(), rows.size() * 64 + 16);
+            w.begin_object().key("rows").begin_array();
+            for (const auto &r: rows) {
+                w.begin_object()
+                        .member("id", r.id)
+                        .member("name", r.name)
+                        .member("score", r.score)
+                        .member("active", r.active)
+                        .end_object();
+            }
+            w.end_array().end_object();
+            bulgogi::set_json(res, w);
+            benchmark::DoNotOptimize(res.body().data());
+            state.counters["bytes"] = static_cast<double>(res.body().size());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}
+
+BENCHMARK(BM_SetJson_Dom)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_SetJson_Writer)->Arg(10)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,96 @@
+/// Copyright (c) 2025 bulgogi-framework
+/// SPDX-License-Identifier: MIT
+// bench/route_table_bench.cpp
+
+/**
+ * @file route_table_bench.cpp
+ * @brief Route lookup: frozen `bulgogi::route_table` vs. the former `std::unordered_map` path.
+ *
+ * The map variant reproduces what `handle_request` used to do per request: copy `req.target()`
+ * into a `std::string`, `substr` away the query and hash the result. The table variant takes a
+ * `std::string_view` straight from the target.
+ *
+ * Run with `--benchmark_filter=Lookup` and compare the 10/100/1000 route arguments.
+ */
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../Web/route_table.hpp"
+
+namespace {
+
+    using Handler = void (*)();
+
+    void handler() {}
+
+    std::vector<std::string> make_paths(std::size_t n) {
+        std::vector<std::string> paths;
+        paths.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            paths.push_back("/api/v" + std::to_string(i % 3) + "/resource_" + std::to_string(i) + "/items");
+        }
+        return paths;
+    }
+
+    /// @brief Request targets as they arrive on the wire: a registered path plus a query string.
+    std::vector<std::string> make_targets(const std::vector<std::string> &paths) {
+        std::vector<std::string> targets;
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<std::size_t> pick(0, paths.size() - 1);
+        for (int i = 0; i < 1024; ++i) targets.push_back(paths[pick(rng)] + "?id=" + std::to_string(i));
+        return targets;
+    }
+
+    void BM_Lookup_UnorderedMap(benchmark::State &state) {
+        const auto paths = make_paths(static_cast<std::size_t>(state.range(0)));
+        const auto targets = make_targets(paths);
+        std::unordered_map<std::string, Handler> map;
+        for (const auto &p: paths) map[p] = handler;
+
+        std::size_t i = 0;
+        for (auto _: state) {
+            const std::string target = targets[i++ & 1023];
+            const auto query_pos = target.find('?');
+            const std::string route = query_pos == std::string::npos ? target : target.substr(0, query_pos);
+            auto it = map.find(route);
+            benchmark::DoNotOptimize(it);
+        }
+    }
+
+    void BM_Lookup_RouteTable(benchmark::State &state) {
+        const auto paths = make_paths(static_cast<std::size_t>(state.range(0)));
+        const auto targets = make_targets(paths);
+        std::vector<std::pair<std::string, Handler>> routes;
+        for (const auto &p: paths) routes.emplace_back(p, handler);
+        const bulgogi::route_table<Handler> table{routes};
+
+        std::size_t i = 0;
+        for (auto _: state) {
+            const std::string_view target = targets[i++ & 1023];
+            const Handler *h = table.find(bulgogi::route_of(target));
+            benchmark::DoNotOptimize(h);
+        }
+    }
+
+    void BM_Lookup_RouteTable_Miss(benchmark::State &state) {
+        const auto paths = make_paths(static_cast<std::size_t>(state.range(0)));
+        std::vector<std::pair<std::string, Handler>> routes;
+        for (const auto &p: paths) routes.emplace_back(p, handler);
+        const bulgogi::route_table<Handler> table{routes};
+        const std::string target = "/api/v9/not_registered/items?id=1";
+
+        for (auto _: state) {
+            const Handler *h = table.find(bulgogi::route_of(target));
+            benchmark::DoNotOptimize(h);
+        }
+    }
+}
+
+BENCHMARK(BM_Lookup_UnorderedMap)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_Lookup_RouteTable)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_Lookup_RouteTable_Miss)->Arg(10)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN();
@@ -6,14 +6,46 @@
 #include <boost/asio.hpp>
 #include <boost/json.hpp>
 #include <iostream>
-#include <unordered_map>
 #include <sstream>
 #include <thread>
 #include <csignal>
 #include <atomic>
 #include <vector>
+#include <list>
+#include <algorithm>
+#include <deque>
 #include <mutex>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
 #include "Web/views.hpp"
+#include "Web/sessions.hpp"
+#include "Web/route_table.hpp"
+#include "Web/static_files.hpp"
+#include "Web/metrics.hpp"
+#include "Web/logger.hpp"
+#include "Web/rate_limit.hpp"
+#ifdef ENABLE_COMPRESSION
+#include "Web/compression.hpp"
+#endif
+#ifdef ENABLE_TLS
+#include <boost/beast/ssl.hpp>
+#include "Web/tls.hpp"
+#endif
+#ifdef ENABLE_HTTP2
+#include "Web/http2.hpp"
+#endif
+#if BULGOGI_SENDFILE
+#include <sys/sendfile.h>
+#endif
+#ifdef REUSEPORT
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 
 namespace beast = boost::beast;
@@ -23,71 +55,324 @@ namespace json = boost::json;
 
 using tcp = boost::asio::ip::tcp;
 
+/// @brief A registered handler with the CORS policy attached by `REGISTER_CORS`, the
+///        response pre-rendered by `REGISTER_CONSTANT` and the `REGISTER_CACHE` policy, if any.
+template<typename Handler>
+struct Route {
+    Handler handler = nullptr;
+    const bulgogi::cors_policy *cors = nullptr;
+    const bulgogi::canned_response *constant = nullptr;
+    std::uint32_t metric = bulgogi::metrics::unmatched;
+    views::body_rule body;
+    const bulgogi::cache_policy *cache = nullptr;
+    bool constant_head = false;  // the handler answers HEAD with 2xx, so `constant` serves it too
+};
+
+/// @brief A `REGISTER_STATIC` directory and its metrics id.
+struct StaticMount {
+    bulgogi::static_files files;
+    std::uint32_t metric = bulgogi::metrics::unmatched;
+};
+
+/// @brief Routing state frozen at start-up: exact paths first, then patterns, then static mounts.
+struct RouteMap {
+    bulgogi::route_table<Route<views::HandlerFunc>> exact;
+    bulgogi::path_router<Route<views::PatternHandlerFunc>> patterns;
+    bulgogi::path_router<StaticMount> statics;
+    std::vector<std::unique_ptr<const bulgogi::canned_response>> constants;  // owned here, pointed to by routes
+    bulgogi::route_table<Route<views::WebSocketFunc>> websockets;           // upgrade requests only
+};
+
 std::atomic g_should_exit = false;
-std::unique_ptr<tcp::acceptor> global_acceptor;
+/// @brief Listening sockets: one shared accept loop, or one per shard with `REUSEPORT`.
+std::vector<std::unique_ptr<tcp::acceptor>> global_acceptors;
+std::unique_ptr<net::signal_set> global_signals;
 
-std::vector<std::thread> session_threads;
+#ifdef ENABLE_TLS
+/// @brief Server TLS context shared by every connection, built by `run_server`.
+std::unique_ptr<net::ssl::context> global_tls;
+
+using session_stream = beast::ssl_stream<beast::tcp_stream>;
+#else
+using session_stream = beast::tcp_stream;
+#endif
+
+class session;
+
+/// @brief Registry of live sessions and the accept loops parked while at `MAX_SESSIONS`.
 std::mutex session_mutex;
+std::list<std::weak_ptr<session>> live_sessions;
+std::deque<std::function<void()>> parked_accepts;
+
+void close_idle_sessions();
 
-void handle_signal(const int signal) {
-    if (signal == SIGTERM || signal == SIGINT) {
-        if (global_acceptor) {
+/**
+ * @brief Stop accepting new connections.
+ *
+ * Each acceptor lives on a strand, so closing is posted there instead of racing the pending
+ * `async_accept`. Sessions idling on keep-alive are closed; sessions in the middle of a request
+ * are allowed to finish. Once the last one is done every `io_context::run()` returns and `run_server`
+ * proceeds to `views::atexit()`.
+ */
+void stop_server() {
+    for (const auto &acceptor: global_acceptors) {
+        net::post(acceptor->get_executor(), [&acceptor = *acceptor] {
+            boost::system::error_code ec;
+            auto err = acceptor.close(ec);
+            (void) err;
+        });
+    }
+    if (global_signals) {
+        net::post(global_signals->get_executor(), [] {
             boost::system::error_code ec;
-            auto err = global_acceptor->close(ec);
+            auto err = global_signals->cancel(ec);
             (void) err;
+        });
+    }
+    close_idle_sessions();
+    bulgogi::websocket::close_all(bulgogi::websocket::going_away);
+}
+
+/**
+ * @brief Return a session slot and wake one acceptor if any is waiting for one.
+ *
+ * Parked continuations are checked under `session_mutex`, the same lock an acceptor holds while
+ * deciding to park, so a release can never slip between a failed reservation and parking.
+ */
+void release_session_slot() {
+    bulgogi::sessions::release();
+
+    std::function<void()> resume;
+    {
+        std::lock_guard lock(session_mutex);
+        if (!parked_accepts.empty()) {
+            resume = std::move(parked_accepts.front());
+            parked_accepts.pop_front();
         }
     }
+    if (resume) resume();
 }
 
-std::unordered_map<std::string, views::HandlerFunc> build_route_map() {
-    std::unordered_map<std::string, views::HandlerFunc> map;
+/**
+ * @brief Call a `REGISTER_CONSTANT` handler once with a synthetic request of @p method.
+ * @throws std::invalid_argument if the handler streams its body.
+ */
+bulgogi::Response probe_constant(const std::string &path, views::HandlerFunc handler, http::verb method) {
+    bulgogi::Request probe{method, "/" + path, 11};
+    bulgogi::Response res;
+    bulgogi::detail::stream_slot().reset();
+    handler(probe, res, bulgogi::remote_address{});
+    bulgogi::detail::body_slot().reset();
+    if (bulgogi::detail::stream_slot()) {
+        bulgogi::detail::stream_slot().reset();
+        throw std::invalid_argument("REGISTER_CONSTANT: '" + path + "' streams its body");
+    }
+    return res;
+}
+
+/// @brief Freeze the `GET` response of a `REGISTER_CONSTANT` handler.
+bulgogi::canned_response render_constant(const std::string &path, views::HandlerFunc handler) {
+    return bulgogi::canned_response(probe_constant(path, handler, http::verb::get));
+}
+
+/// @brief Whether the handler accepts `HEAD` itself, so it may be answered from the `GET` snapshot.
+bool constant_allows_head(const std::string &path, views::HandlerFunc handler) {
+    const auto res = probe_constant(path, handler, http::verb::head);
+    return http::to_status_class(res.result()) == http::status_class::successful;
+}
+
+RouteMap build_route_map() {
+    const auto cors_of = [](const std::string &path) -> const bulgogi::cors_policy * {
+        const auto it = views::cors_map.find(path);
+        return it == views::cors_map.end() ? nullptr : it->second;
+    };
+    const auto body_of = [](const std::string &path) {
+        const auto it = views::body_map.find(path);
+        return it == views::body_map.end() ? views::body_rule{} : it->second;
+    };
+    const auto cache_of = [](const std::string &path) -> const bulgogi::cache_policy * {
+        const auto it = views::cache_map.find(path);
+        return it == views::cache_map.end() ? nullptr : it->second;
+    };
+    const auto is_view = [](const std::string &path) {
+        return views::function_map.contains(path) ||
+               std::any_of(views::pattern_map.begin(), views::pattern_map.end(),
+                           [&path](const auto &entry) { return entry.first == path; });
+    };
+    for (const auto &[path, _]: views::body_map) {
+        if (!is_view(path)) {
+            throw std::invalid_argument("REGISTER_BODY_LIMIT: '" + path + "' is not a registered view");
+        }
+    }
+    for (const auto &[path, _]: views::cache_map) {
+        if (!is_view(path)) {
+            throw std::invalid_argument("REGISTER_CACHE: '" + path + "' is not a registered view");
+        }
+    }
+
+    std::vector<std::unique_ptr<const bulgogi::canned_response>> constants;
+    std::unordered_map<std::string_view, std::pair<const bulgogi::canned_response *, bool>> constant_of;
+    for (const auto &path: views::constant_routes) {
+        const auto it = views::function_map.find(path);
+        if (it == views::function_map.end()) {
+            throw std::invalid_argument("REGISTER_CONSTANT: '" + path + "' is not a registered view");
+        }
+        constants.push_back(std::make_unique<const bulgogi::canned_response>(render_constant(path, it->second)));
+        constant_of[path] = {constants.back().get(), constant_allows_head(path, it->second)};
+    }
+
+    std::vector<std::pair<std::string, Route<views::HandlerFunc>>> routes;
+    routes.reserve(views::function_map.size());
     for (const auto &[name, func]: views::function_map) {
-        map["/" + name] = func;
+        const auto constant = constant_of.find(name);
+        const bool is_constant = constant != constant_of.end();
+        routes.emplace_back("/" + name, Route<views::HandlerFunc>{
+                func, cors_of(name), is_constant ? constant->second.first : nullptr,
+                bulgogi::metrics::add_route("/" + name), body_of(name), cache_of(name),
+                is_constant && constant->second.second});
+    }
+
+    RouteMap map{bulgogi::route_table<Route<views::HandlerFunc>>{routes}, {}, {}, std::move(constants), {}};
+    for (const auto &[pattern, func]: views::pattern_map) {
+        map.patterns.add(pattern, Route<views::PatternHandlerFunc>{
+                func, cors_of(pattern), nullptr, bulgogi::metrics::add_route("/" + pattern), body_of(pattern),
+                cache_of(pattern)});
+    }
+    for (const auto &[prefix, root]: views::static_map) {
+        std::string mount = prefix;
+        while (!mount.empty() && mount.back() == '/') mount.pop_back();
+        map.statics.add(mount.empty() ? "{*path}" : mount + "/{*path}",
+                        StaticMount{bulgogi::static_files(root),
+                                    bulgogi::metrics::add_route(mount.empty() ? "/*" : "/" + mount + "/*")});
+    }
+
+    std::vector<std::pair<std::string, Route<views::WebSocketFunc>>> sockets;
+    sockets.reserve(views::websocket_map.size());
+    for (const auto &[path, func]: views::websocket_map) {
+        // A view on the same path shares its metrics series
+        const auto *view = map.exact.find("/" + path);
+        sockets.emplace_back("/" + path, Route<views::WebSocketFunc>{
+                func, nullptr, nullptr, view ? view->metric : bulgogi::metrics::add_route("/" + path), {}, nullptr});
     }
+    map.websockets = bulgogi::route_table<Route<views::WebSocketFunc>>{sockets};
     return map;
 }
 
-void handle_request(
-        const std::unordered_map<std::string, views::HandlerFunc>& route_map,
+/// @brief How the body of a request is read, decided from its target once the headers are in.
+struct BodyPolicy {
+    views::body_rule rule;
+    std::uint32_t metric = bulgogi::metrics::unmatched;
+};
+
+BodyPolicy body_policy(const RouteMap &route_map, std::string_view target) {
+    const std::string_view route = bulgogi::route_of(target);
+    if (const auto *exact = route_map.exact.find(route)) return {exact->body, exact->metric};
+    bulgogi::path_params params;
+    if (const auto *pattern = route_map.patterns.match(route, params)) return {pattern->body, pattern->metric};
+    if (const auto *mount = route_map.statics.match(route, params)) return {{}, mount->metric};
+    return {};
+}
+
+/// @brief Whether the client waits for `100 Continue` before sending the body.
+bool expects_continue(const http::request_header<> &req) {
+    return req.version() >= 11 && beast::iequals(req[http::field::expect], "100-continue");
+}
+
+/**
+ * @brief Route one request and produce its response.
+ * @param metric Set to the metrics id of the matched route.
+ * @return A pre-rendered response to write instead of @p res (a constant route, a cached
+ *         CORS preflight or a rate-limit `429`), or `nullptr` when @p res holds the answer.
+ */
+const bulgogi::canned_response *route_request(
+        const RouteMap& route_map,
         const http::request<http::string_body>& req,
         http::response<http::string_body>& res,
-        const std::string& remote_ip) {
+        const bulgogi::remote_address& remote_ip,
+        std::uint32_t& metric) {
+
+    const std::string_view route = bulgogi::route_of(req.target());
+    const auto *exact = route_map.exact.find(route);
+
+    bulgogi::path_params params;
+    const auto *pattern = exact ? nullptr : route_map.patterns.match(route, params);
+    const views::HandlerFunc handler = exact ? exact->handler : nullptr;
+    const views::PatternHandlerFunc pattern_handler = pattern ? pattern->handler : nullptr;
+    const bulgogi::cors_policy *cors = exact ? exact->cors : pattern ? pattern->cors : nullptr;
+    const StaticMount *mount = handler || pattern_handler ? nullptr : route_map.statics.match(route, params);
+    // Plain requests to a WebSocket-only path are told to upgrade
+    const auto *socket = handler || pattern_handler || mount ? nullptr : route_map.websockets.find(route);
+    if (exact) metric = exact->metric;
+    else if (pattern) metric = pattern->metric;
+    else if (mount) metric = mount->metric;
+    else if (socket) metric = socket->metric;
+
+    if constexpr (bulgogi::rate_limit::enabled) {
+        if (remote_ip.known()) {
+            if (const auto *limited = bulgogi::rate_limit::admit_request(remote_ip.address(), metric)) return limited;
+        }
+    }
+
+    // Constant routes: same-origin GET (and HEAD, if the handler accepts it) is answered with the
+    // bytes rendered at start-up
+    if (exact && exact->constant &&
+        (req.method() == http::verb::get || (req.method() == http::verb::head && exact->constant_head)) &&
+        req.find(http::field::origin) == req.end()) {
+        return exact->constant;
+    }
+
+    // Cached routes: a stored response for the same key skips the handler altogether
+    const bulgogi::cache_policy *cache = exact ? exact->cache : pattern ? pattern->cache : nullptr;
+    std::string cache_key;
+    if (cache && bulgogi::response_cache::cacheable(req, *cache)) {
+#ifdef ENABLE_COMPRESSION
+        cache_key = bulgogi::response_cache::key_of(
+                req, *cache, bulgogi::compression::name_of(bulgogi::compression::negotiate(req)));
+#else
+        cache_key = bulgogi::response_cache::key_of(req, *cache);
+#endif
+        if (const auto *hit = bulgogi::response_cache::lookup(cache_key)) return hit;
+    }
 
     res.version(req.version());
     res.keep_alive(req.keep_alive());
 
-    const std::string target = std::string(req.target());
-    const auto query_pos = target.find('?');
-    const std::string route = query_pos == std::string::npos ? target : target.substr(0, query_pos);
-
     // === Special handling for OPTIONS preflight ===
     if (req.method() == http::verb::options) {
-        if (views::has_route(route)) {
+        if (handler || pattern_handler || mount) {
             try {
                 views::check_head(req);  // allow filtering on Origin / Headers
+                // Declared policy: answer from the pre-rendered block, the handler would only repeat it
+                if (cors && cors->enabled() && cors->accepts_origin(req[http::field::origin])) {
+                    return &cors->preflight();
+                }
                 res.result(http::status::no_content);
             } catch (const std::exception& e) {
                 bulgogi::set_json(res, {
                         {"error", std::string("CORS preflight rejected: ") + e.what()}
                 }, 403);
                 bulgogi::apply_cors(res);  // optional for visibility
-                return;
+                return nullptr;
             } // legal, continue to regular request handling to get full cors
         } else {
-            bulgogi::set_text(res, "404 Not Found (CORS preflight): " + route, 404);
+            bulgogi::set_text(res, "404 Not Found (CORS preflight): " + std::string(route), 404);
             bulgogi::apply_cors(res);  // optional for visibility
-            return;
+            return nullptr;
         }
     }
 
     // === Regular request handling ===
-    auto it = route_map.find(route);
-    if (it != route_map.end()) {
+    if (handler || pattern_handler) {
         bulgogi::Response hres;
 
+        bulgogi::detail::stream_slot().reset();
+        bulgogi::detail::body_slot().reset();
         try {
-            it->second(req, hres, remote_ip);
+            if (handler) handler(req, hres, remote_ip);
+            else pattern_handler(req, hres, params, remote_ip);
         } catch (const std::exception& e) {
+            bulgogi::detail::stream_slot().reset();
+            bulgogi::detail::body_slot().reset();
 #ifndef NDEBUG
             bulgogi::set_json(hres, {{"error", e.what()}}, 400);
 #else
@@ -95,116 +380,1339 @@ void handle_request(
 #endif
         }
 
+        // The handler builds a fresh response, so restore the connection semantics negotiated
+        // with the client. A handler may still opt out of keep-alive by clearing it on `hres`.
+        const bool keep_alive = req.keep_alive() && hres.keep_alive();
         res = std::move(hres);
+        res.version(req.version());
+        res.keep_alive(keep_alive);
+        // Handlers that only set headers (e.g. preflight via check_method) leave the body length
+        // unset, which would make a keep-alive client wait for the connection to close.
+        if (!res.has_content_length() && !res.chunked()) res.prepare_payload();
+#ifdef ENABLE_COMPRESSION
+        bulgogi::compression::compress_response(req, res);
+#endif
+        // Only complete GET bodies are stored; HEAD has none and streamed ones are produced later
+        if (!cache_key.empty() && req.method() == http::verb::get &&
+            !bulgogi::detail::stream_slot() && !bulgogi::detail::body_slot()) {
+            bulgogi::response_cache::store(std::move(cache_key), res, *cache);
+        }
+    } else if (mount) {
+        bulgogi::detail::file_slot().reset();
+        mount->files.serve(req, res, params["path"]);
+    } else if (socket) {
+        bulgogi::set_text(res, "426 Upgrade Required", 426);
+        res.set(http::field::upgrade, "websocket");
+        res.set(http::field::connection, "Upgrade");
     } else {
-        bulgogi::set_text(res, "404 Not Found: " + route, 404);
+        bulgogi::set_text(res, "404 Not Found: " + std::string(route), 404);
     }
+    return nullptr;
 }
 
-void do_session(tcp::socket socket,
-                const std::shared_ptr<const std::unordered_map<std::string, views::HandlerFunc>> &route_map) {
-    try {
-        beast::flat_buffer buffer;
-        http::request<http::string_body> req;
+/**
+ * @brief `route_request` with its status and handling time recorded under the matched route.
+ *
+ * The time covers routing and the handler; streamed and sendfile bodies are produced later,
+ * while being written, and count towards `bulgogi_sent_bytes_total` only.
+ */
+const bulgogi::canned_response *handle_request(
+        const RouteMap& route_map,
+        const http::request<http::string_body>& req,
+        http::response<http::string_body>& res,
+        const bulgogi::remote_address& remote_ip) {
+    const auto start = std::chrono::steady_clock::now();
+    std::uint32_t metric = bulgogi::metrics::unmatched;
+    const bulgogi::canned_response *canned = route_request(route_map, req, res, remote_ip, metric);
+    bulgogi::metrics::observe(metric, canned ? canned->status() : res.result_int(),
+                              std::chrono::steady_clock::now() - start);
+    return canned;
+}
 
-        auto remote_ip = socket.remote_endpoint().address().to_string();
+/**
+ * @brief A connection upgraded by a `REGISTER_WEBSOCKET` route.
+ *
+ * It takes over the HTTP session's stream, strand and `MAX_SESSIONS` slot. One read is always
+ * pending; writes drain `queue_` one message at a time, each as a single unfragmented frame
+ * pointing at the shared payload. Closing waits for the write in progress, discards the rest of
+ * the queue and sends a close frame; the pending read then completes with the peer's answer (or
+ * the handshake timeout) and the connection leaves its topics.
+ */
+class ws_session final : public bulgogi::websocket::connection {
+    beast::websocket::stream<session_stream> ws_;
+    beast::flat_buffer buffer_;
+    bulgogi::websocket::upgrade handlers_;
+    http::request<http::string_body> request_;  // kept until the handshake is written
+    std::deque<bulgogi::websocket::message> queue_;
+    std::uint16_t close_code_ = 0;  // close frame still to send once the current write is done
+    bool open_ = false;
 
-        beast::tcp_stream stream(std::move(socket));
-        stream.expires_after(std::chrono::seconds(TIMEOUT));
+public:
+    ws_session(session_stream &&stream, const bulgogi::remote_address &ip, bulgogi::websocket::upgrade &&handlers)
+            : connection(ip), ws_(std::move(stream)), handlers_(std::move(handlers)) {}
 
-        http::read(stream, buffer, req);
+    ~ws_session() override {
+        release_session_slot();
+    }
 
-        if (g_should_exit) return;
+    /// @brief Answer @p req with `101 Switching Protocols` and start reading messages.
+    void run(http::request<http::string_body> &&req) {
+        request_ = std::move(req);
+        // From here on the websocket stream's own timeouts apply: handshakes, and pings after idling
+        beast::get_lowest_layer(ws_).expires_never();
+        ws_.set_option(beast::websocket::stream_base::timeout::suggested(beast::role_type::server));
+        ws_.read_message_max(MAX_BODY_SIZE);
+        ws_.auto_fragment(false);
+        ws_.async_accept(request_, beast::bind_front_handler(&ws_session::on_accept, self()));
+    }
 
-        http::response<http::string_body> res;
-        handle_request(*route_map, req, res, remote_ip);
+protected:
+    void enqueue(bulgogi::websocket::message m) override {
+        net::post(ws_.get_executor(), [self = self(), m = std::move(m)]() mutable {
+            if (self->close_code_ || !self->is_open()) return self->dequeued(m->payload.size());
+            self->queue_.push_back(std::move(m));
+            if (self->queue_.size() == 1) self->do_write();
+        });
+    }
 
-        http::write(stream, res);
+    void shut(std::uint16_t code) override {
+        // Posted, never dispatched: the caller may hold locks (a publisher closing a slow consumer)
+        net::post(ws_.get_executor(), [self = self(), code] {
+            if (!self->open_) return;
+            self->close_code_ = code;
+            // Drop everything behind the message being written
+            while (self->queue_.size() > 1) {
+                self->dequeued(self->queue_.back()->payload.size());
+                self->queue_.pop_back();
+            }
+            if (self->queue_.empty()) self->do_close();
+        });
+    }
 
-        boost::system::error_code ec;
-        auto& sock = stream.socket();
+private:
+    std::shared_ptr<ws_session> self() {
+        return std::static_pointer_cast<ws_session>(shared_from_this());
+    }
 
-        const auto& result = sock.shutdown(tcp::socket::shutdown_send, ec);
-        // Reference of ec, nodiscard
-        if (result && result != boost::asio::error::not_connected) {
-            std::cerr << "Shutdown failed: " << ec.message() << std::endl;
+    void on_accept(beast::error_code ec) {
+        request_ = {};
+        if (ec) return report(ec);
+        open_ = true;
+        opened();
+        try {
+            for (const auto &topic: handlers_.topics) subscribe(topic);
+            if (handlers_.on_open) handlers_.on_open(*this);
+        } catch (const std::exception &e) {
+            bulgogi::log::error(std::string("WebSocket on_open failed: ") + e.what());
+            close(bulgogi::websocket::internal_error);
         }
+        do_read();
+    }
+
+    void do_read() {
+        ws_.async_read(buffer_, beast::bind_front_handler(&ws_session::on_read, self()));
+    }
 
-    } catch (const beast::system_error &e) {
-        if (!g_should_exit && e.code() != http::error::partial_message) {
-            if (e.code() == http::error::end_of_stream) {
-                std::clog << "[debug] Client disconnected\n";
-            } else {
-                std::cerr << "Session error: " << e.what() << std::endl;
+    void on_read(beast::error_code ec, std::size_t bytes) {
+        if (ec) return finish(ec);
+        bulgogi::metrics::add_bytes_in(bytes);
+        if (handlers_.on_message && is_open()) {
+            const auto data = buffer_.cdata();
+            try {
+                handlers_.on_message(*this, {static_cast<const char *>(data.data()), data.size()}, ws_.got_binary());
+            } catch (const std::exception &e) {
+                bulgogi::log::error(std::string("WebSocket on_message failed: ") + e.what());
+                close(bulgogi::websocket::internal_error);
             }
         }
-        // Force shutdown silently
-    } catch (const std::exception &e) {
-        if (!g_should_exit) {
-            std::cerr << "Session exception: " << e.what() << std::endl;
+        buffer_.consume(buffer_.size());
+        do_read();
+    }
+
+    void do_write() {
+        const auto &m = queue_.front();
+        ws_.binary(m->binary);
+        ws_.async_write(net::buffer(m->payload), beast::bind_front_handler(&ws_session::on_write, self()));
+    }
+
+    void on_write(beast::error_code ec, std::size_t bytes) {
+        bulgogi::metrics::add_bytes_out(bytes);
+        dequeued(queue_.front()->payload.size());
+        queue_.pop_front();
+        if (ec) {
+            // The read fails as well and ends the connection; release what is still queued
+            for (const auto &m: queue_) dequeued(m->payload.size());
+            queue_.clear();
+            return;
         }
+        if (close_code_) return do_close();
+        if (!queue_.empty()) do_write();
     }
-}
 
+    void do_close() {
+        ws_.async_close(beast::websocket::close_reason(close_code_),
+                        [self = self()](beast::error_code) {});
+    }
 
-int main() {
-    std::signal(SIGINT, handle_signal);
-    std::signal(SIGTERM, handle_signal);
-    views::init();
+    /// @brief The read loop ended: the peer closed, the close handshake completed or the stream failed.
+    void finish(beast::error_code ec) {
+        closed();
+        if (handlers_.on_close) {
+            try {
+                handlers_.on_close(*this);
+            } catch (const std::exception &e) {
+                bulgogi::log::error(std::string("WebSocket on_close failed: ") + e.what());
+            }
+        }
+        if (ec != beast::websocket::error::closed) report(ec);
+    }
+
+    static void report(beast::error_code ec) {
+        if (ec == beast::error::timeout) bulgogi::metrics::count_timeout();
+        if (g_should_exit || ec == net::error::eof || ec == net::error::connection_reset ||
+            ec == net::error::operation_aborted) return;
+#ifdef ENABLE_TLS
+        if (ec == net::ssl::error::stream_truncated) return;
+#endif
+        bulgogi::log::debug("WebSocket error: " + ec.message());
+    }
+};
+
+/**
+ * @brief One HTTP connection driven by asynchronous reads and writes.
+ *
+ * The session owns its stream, buffer and message objects and keeps itself alive through
+ * `shared_from_this()` captured by every pending operation. All of its handlers run on the
+ * per-connection strand the socket was accepted on, so no locking is needed inside.
+ *
+ * While the client negotiates keep-alive the session loops on the same stream and buffer:
+ * - Between requests it waits at most `KEEP_ALIVE_TIMEOUT` seconds for the first byte, after
+ *   which the rest of the request must arrive within the regular `TIMEOUT`.
+ * - Pipelined requests already sitting in `buffer_` are parsed straight away, and responses are
+ *   written strictly in request order.
+ * - After `MAX_KEEP_ALIVE_REQUESTS` responses (0 = unlimited) the connection is closed with
+ *   `Connection: close`.
+ *
+ * Responses set up with `bulgogi::set_stream` are written through a `buffer_body` serializer:
+ * the producer refills one `STREAM_BUFFER_SIZE` buffer after each socket write, so memory per
+ * streaming connection stays bounded whatever the body size.
+ *
+ * Large static files are sent with `sendfile(2)` after the headers: the kernel copies the file
+ * to the socket directly, and the session only waits for the socket to become writable again.
+ *
+ * Requests are read in two steps. Once the headers are in, the route decides how the body is
+ * taken: its size limit (`REGISTER_BODY_LIMIT`, else `MAX_BODY_SIZE`) is checked against
+ * `Content-Length` before any of it is read, `Expect: 100-continue` is answered, and on
+ * `REGISTER_STREAMING_BODY` routes the handler runs right away and receives the body through a
+ * `buffer_body` parser, one `STREAM_BUFFER_SIZE` piece at a time. Oversized bodies get `413`
+ * and the connection is closed.
+ *
+ * Each response is logged once it is written (or abandoned) through `bulgogi::log`, with the
+ * bytes actually sent and the time since its request headers were read.
+ *
+ * With `ENABLE_HTTP2` a connection can instead speak HTTP/2: in plaintext when its first bytes
+ * are the h2c connection preface (prior knowledge), under TLS when ALPN selected `h2`. The session
+ * then runs a single loop (read, hand the bytes to `bulgogi::http2::connection`, write what it
+ * queued) and every request stream is routed, rate-limited, body-limited and logged like an
+ * HTTP/1 request. Responses of all streams are interleaved on the connection as their flow-control
+ * windows allow; files are read through a stream producer since `sendfile` cannot frame them.
+ *
+ * An HTTP/1.1 upgrade request to a `REGISTER_WEBSOCKET` path ends the session: once the handler
+ * accepted it, the stream is moved into a `ws_session` and this object goes away.
+ */
+class session : public std::enable_shared_from_this<session> {
+    static constexpr std::size_t idle_read_size = 4096;
+
+    struct body_stream {
+        http::response<http::buffer_body> res;
+        http::response_serializer<http::buffer_body> sr{res};
+        bulgogi::detail::pending_stream source;
+        std::uint64_t sent = 0;
+        std::unique_ptr<char[]> buffer = std::make_unique<char[]>(STREAM_BUFFER_SIZE);
+
+        body_stream(http::response_header<> &&header, bulgogi::detail::pending_stream &&pending)
+                : res(std::move(header)), source(std::move(pending)) {}
+    };
+
+    /// @brief A request body being passed to the handler's `receive_body` consumer.
+    struct upload {
+        http::request_parser<http::buffer_body> parser;
+        bulgogi::detail::pending_body body;
+        std::unique_ptr<char[]> buffer = std::make_unique<char[]>(STREAM_BUFFER_SIZE);
+
+        explicit upload(http::request_parser<http::string_body> &&header) : parser(std::move(header)) {}
+    };
 
-    auto route_map = std::make_shared<std::unordered_map<std::string, views::HandlerFunc>>(build_route_map());
-    std::cout << "Registered routes:" << std::endl;
-    for (const auto &[name, _]: *route_map) {
-        std::cout << name << std::endl;
+#if BULGOGI_SENDFILE
+    /// @brief Bytes sent per turn before yielding the thread to other connections.
+    static constexpr std::size_t sendfile_turn_bytes = 1 << 20;
+
+    struct file_transfer {
+        bulgogi::detail::pending_file file;
+        net::steady_timer timer;  // the stream's own timeout does not cover raw socket waits
+    };
+#endif
+
+    session_stream stream_;
+    net::any_io_executor executor_;  // the strand, still reachable once a WebSocket took the stream
+    beast::flat_buffer buffer_;
+    std::optional<http::request_parser<http::string_body>> parser_;
+    http::request<http::string_body> req_;
+    http::response<http::string_body> res_;
+    std::shared_ptr<const RouteMap> route_map_;
+    bulgogi::remote_address remote_ip_;
+    std::unique_ptr<body_stream> body_stream_;
+    std::unique_ptr<upload> upload_;
+    std::uint32_t body_metric_ = bulgogi::metrics::unmatched;  // route of the body being read, for 413s
+#if BULGOGI_SENDFILE
+    std::unique_ptr<file_transfer> file_;
+#endif
+    bulgogi::response_cache::pinned_response pinned_;  // cache entry being written, may be evicted meanwhile
+    std::size_t served_ = 0;
+    std::chrono::steady_clock::time_point started_;  // current response, for the access log
+    unsigned status_ = 0;
+    std::uint64_t sent_ = 0;
+    bool keep_alive_ = false;
+    bool idle_ = false;
+    bool upgraded_ = false;  // the stream and session slot now belong to a `ws_session`
+#ifdef ENABLE_TLS
+    bool ktls_ = false;  // the kernel encrypts writes, so sendfile can be used
+#endif
+#ifdef ENABLE_HTTP2
+    std::unique_ptr<bulgogi::http2::connection> h2_;
+#endif
+    std::list<std::weak_ptr<session>>::iterator registration_;
+
+    static session_stream make_stream(tcp::socket &&socket) {
+#ifdef ENABLE_TLS
+        return session_stream(std::move(socket), *global_tls);
+#else
+        return session_stream(std::move(socket));
+#endif
     }
 
-    try {
-        net::io_context ioc{1};
-        global_acceptor = std::make_unique<tcp::acceptor>(ioc, tcp::endpoint{tcp::v4(), PORT});
+    /// @brief The TCP layer, for timeouts and raw socket access under TLS as well.
+    beast::tcp_stream &tcp_stream() { return beast::get_lowest_layer(stream_); }
 
-        auto io_runner = [&ioc]() {
-            ioc.run();
-        };
-        std::thread(std::move(io_runner)).detach();
+public:
+    /// @brief Construct with a session slot already reserved; it is released on destruction.
+    session(tcp::socket &&socket, std::shared_ptr<const RouteMap> route_map)
+            : stream_(make_stream(std::move(socket))), executor_(stream_.get_executor()),
+              route_map_(std::move(route_map)) {
+        boost::system::error_code ec;
+        const auto endpoint = tcp_stream().socket().remote_endpoint(ec);
+        if (!ec) remote_ip_ = bulgogi::remote_address{endpoint.address()};
+        // Responses are written in whole messages; a streamed body's header and first piece go out
+        // as separate writes, which Nagle would hold back until the client's delayed ACK
+        auto err = tcp_stream().socket().set_option(tcp::no_delay(true), ec);
+        (void) err;
+    }
 
-        std::cout << "HTTP server running on port " STR(PORT) "..." << std::endl;
+    ~session() {
+        if (!upgraded_) {
+            std::lock_guard lock(session_mutex);
+            live_sessions.erase(registration_);
+        }
+        if (!upgraded_) release_session_slot();
+    }
 
-        while (!g_should_exit) {
-            tcp::socket socket{ioc};
-            boost::system::error_code ec;
-            auto err = global_acceptor->accept(socket, ec);
-            (void) err;
+    session(const session &) = delete;
+    session &operator=(const session &) = delete;
 
-            if (ec == boost::asio::error::operation_aborted) break;
+    static void start(tcp::socket &&socket, std::shared_ptr<const RouteMap> route_map) {
+        auto self = std::make_shared<session>(std::move(socket), std::move(route_map));
+        {
+            std::lock_guard lock(session_mutex);
+            self->registration_ = live_sessions.insert(live_sessions.end(), self);
+        }
+#ifdef ENABLE_TLS
+        net::dispatch(self->stream_.get_executor(),
+                      beast::bind_front_handler(&session::do_handshake, self));
+#elif defined(ENABLE_HTTP2)
+        net::dispatch(self->stream_.get_executor(),
+                      beast::bind_front_handler(&session::do_detect, self));
+#else
+        net::dispatch(self->stream_.get_executor(),
+                      beast::bind_front_handler(&session::do_read, self));
+#endif
+    }
 
-            if (ec) {
-                std::cerr << "Accept error: " << ec.message() << std::endl;
-                continue;
+    /// @brief Close the connection if it is waiting between keep-alive requests.
+    void close_if_idle() {
+        net::dispatch(executor_, [self = shared_from_this()] {
+            if (self->idle_) self->tcp_stream().cancel();
+        });
+    }
+
+private:
+#ifdef ENABLE_TLS
+    void do_handshake() {
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        stream_.async_handshake(net::ssl::stream_base::server,
+                                beast::bind_front_handler(&session::on_handshake, shared_from_this()));
+    }
+
+    void on_handshake(beast::error_code ec) {
+        if (ec) {
+            // Port scanners and plaintext clients end up here; not worth an error line each
+            bulgogi::tls::record_failure();
+            if (ec == beast::error::timeout) bulgogi::metrics::count_timeout();
+            return bulgogi::log::debug("TLS handshake failed: " + ec.message());
+        }
+        ktls_ = bulgogi::tls::record_handshake(stream_.native_handle());
+#ifdef ENABLE_HTTP2
+        if (bulgogi::tls::negotiated_h2(stream_.native_handle())) return start_http2();
+#endif
+        do_read();
+    }
+#endif
+
+#if defined(ENABLE_HTTP2) && !defined(ENABLE_TLS)
+    /// @brief Read the first bytes and tell an h2c preface from an HTTP/1 request line.
+    void do_detect() {
+        idle_ = true;
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        stream_.async_read_some(buffer_.prepare(idle_read_size),
+                                beast::bind_front_handler(&session::on_detect, shared_from_this()));
+    }
+
+    void on_detect(beast::error_code ec, std::size_t bytes) {
+        idle_ = false;
+        if (ec == beast::error::timeout || ec == net::error::eof ||
+            ec == net::error::operation_aborted) return do_close();
+        if (ec) return report(ec);
+        buffer_.commit(bytes);
+
+        const auto data = buffer_.cdata();
+        switch (bulgogi::http2::match_preface({static_cast<const char *>(data.data()), data.size()})) {
+            case bulgogi::http2::preface::complete:
+                return start_http2();
+            case bulgogi::http2::preface::partial:
+                return do_detect();
+            case bulgogi::http2::preface::mismatch:
+                return do_read();  // the HTTP/1 parser picks up the buffered bytes
+        }
+    }
+#endif
+
+    void do_read() {
+        req_ = {};
+        // The body limit depends on the route, so it is applied once the headers are in
+        parser_.emplace();
+        parser_->body_limit(bulgogi::unlimited_body);
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        http::async_read_header(stream_, buffer_, *parser_,
+                                beast::bind_front_handler(&session::on_header, shared_from_this()));
+    }
+
+    /// @brief Wait for the next request on an idle keep-alive connection.
+    void do_idle_read() {
+        if (buffer_.size() > 0) return do_read();  // pipelined request already buffered
+
+        if (g_should_exit) return do_close();
+
+        idle_ = true;
+        tcp_stream().expires_after(std::chrono::seconds(KEEP_ALIVE_TIMEOUT));
+        stream_.async_read_some(buffer_.prepare(idle_read_size),
+                                beast::bind_front_handler(&session::on_idle_read, shared_from_this()));
+    }
+
+    void on_idle_read(beast::error_code ec, std::size_t bytes) {
+        idle_ = false;
+        // Timing out, the peer closing or shutdown while idle is the normal end of a keep-alive connection
+        if (ec == beast::error::timeout || ec == net::error::eof ||
+            ec == net::error::operation_aborted) return do_close();
+        if (ec) return report(ec);
+        buffer_.commit(bytes);
+        do_read();
+    }
+
+    void on_header(beast::error_code ec, std::size_t bytes) {
+        if (ec) return report(ec);
+        bulgogi::metrics::add_bytes_in(bytes);
+        if (g_should_exit) return do_close();
+
+        started_ = std::chrono::steady_clock::now();
+        sent_ = 0;
+        if (parser_->is_done()) return on_read({}, 0);  // no body
+
+        const auto &header = parser_->get();
+        const auto policy = body_policy(*route_map_, header.target());
+        body_metric_ = policy.metric;
+        const auto length = parser_->content_length();
+        if (length && *length > policy.rule.limit) return reject_body();
+        parser_->body_limit(policy.rule.limit);  // enforced while reading chunked bodies
+
+        if (policy.rule.streaming) return start_upload(policy.rule.limit);
+        if (expects_continue(header)) return send_continue(&session::read_body);
+        read_body();
+    }
+
+    void read_body() {
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        http::async_read(stream_, buffer_, *parser_,
+                         beast::bind_front_handler(&session::on_read, shared_from_this()));
+    }
+
+    void on_read(beast::error_code ec, std::size_t bytes) {
+        if (ec == http::error::body_limit) return reject_body();
+        if (ec) return report(ec);
+        bulgogi::metrics::add_bytes_in(bytes);
+        if (g_should_exit) return do_close();
+
+        req_ = parser_->release();
+        parser_.reset();
+        res_ = {};
+        if (beast::websocket::is_upgrade(req_)) {
+            if (const auto *socket = route_map_->websockets.find(bulgogi::route_of(req_.target()))) {
+                return start_websocket(*socket);
+            }
+        }
+        const bulgogi::canned_response *canned = handle_request(*route_map_, req_, res_, remote_ip_);
+        // The body is already here: a handler asking for it piece by piece gets it in one
+        if (auto body = std::exchange(bulgogi::detail::body_slot(), std::nullopt); body && !canned) {
+            try {
+                if (!req_.body().empty()) body->consumer(req_.body());
+                body->complete(res_);
+                if (!bulgogi::detail::stream_slot()) res_.prepare_payload();
+            } catch (const std::exception &e) {
+                fail_body(e);
             }
+        }
+        respond(canned);
+    }
 
-            auto session = [sock = std::move(socket), route_map]() mutable {
-                do_session(std::move(sock), route_map);
-            };
-            std::lock_guard<std::mutex> lock(session_mutex);
-            session_threads.emplace_back(std::move(session));
+    /**
+     * @brief Run the `REGISTER_WEBSOCKET` handler of @p route on `req_` and, unless it refused,
+     *        hand the stream over to a `ws_session` that completes the handshake.
+     */
+    void start_websocket(const Route<views::WebSocketFunc> &route) {
+        const auto start = std::chrono::steady_clock::now();
+        if constexpr (bulgogi::rate_limit::enabled) {
+            if (remote_ip_.known()) {
+                if (const auto *limited = bulgogi::rate_limit::admit_request(remote_ip_.address(), route.metric)) {
+                    bulgogi::metrics::observe(route.metric, limited->status(), std::chrono::steady_clock::now() - start);
+                    return respond(limited);
+                }
+            }
         }
 
-        ioc.stop();
-        global_acceptor.reset();
+        bulgogi::websocket::upgrade handlers;
+        try {
+            route.handler(req_, handlers, remote_ip_);
+        } catch (const std::exception &e) {
+            set_failure(res_, e);
+            handlers.status = res_.result_int();
+        }
+        if (handlers.status) {
+            if (res_.body().empty()) {
+                const auto status = http::int_to_status(handlers.status);
+                bulgogi::set_text(res_, std::to_string(handlers.status) + " " + std::string(http::obsolete_reason(status)),
+                                  handlers.status);
+            }
+            res_.version(req_.version());
+            res_.keep_alive(req_.keep_alive());
+            bulgogi::metrics::observe(route.metric, handlers.status, std::chrono::steady_clock::now() - start);
+            return respond(nullptr);
+        }
+        bulgogi::metrics::observe(route.metric, 101, std::chrono::steady_clock::now() - start);
 
+        status_ = 101;
+        log_access();
         {
             std::lock_guard lock(session_mutex);
-            for (size_t i = 0; i < session_threads.size(); ++i) { // NOLINT ranged-for illegal
-                if (session_threads.at(i).joinable()) {
-                    session_threads.at(i).join();
+            live_sessions.erase(registration_);
+        }
+        upgraded_ = true;
+        std::make_shared<ws_session>(std::move(stream_), remote_ip_, std::move(handlers))->run(std::move(req_));
+    }
+
+    /// @brief Write the response to `req_`: @p canned if set, `res_` otherwise.
+    void respond(const bulgogi::canned_response *canned, bool close = false) {
+        status_ = canned ? canned->status() : res_.result_int();
+        auto pending = std::exchange(bulgogi::detail::stream_slot(), std::nullopt);
+#if BULGOGI_SENDFILE
+        auto file = std::exchange(bulgogi::detail::file_slot(), std::nullopt);
+#endif
+
+        ++served_;
+        const bool last = close || (MAX_KEEP_ALIVE_REQUESTS > 0 && served_ >= MAX_KEEP_ALIVE_REQUESTS);
+
+        if (canned) {
+            pinned_ = bulgogi::response_cache::take_pinned();
+            keep_alive_ = req_.keep_alive() && !last;
+            return net::async_write(stream_, canned->wire(req_.method() == http::verb::head, req_.version(), keep_alive_,
+                                                          pinned_.age_line),
+                                    beast::bind_front_handler(&session::on_write, shared_from_this()));
+        }
+
+        if (last) res_.keep_alive(false);
+
+#if BULGOGI_SENDFILE
+#ifdef ENABLE_TLS
+        // Without kernel TLS the file has to pass through OpenSSL: read it like a streamed body
+        if (file && !ktls_) {
+            const auto length = file->length;
+            pending = bulgogi::detail::pending_stream{bulgogi::detail::file_producer(std::move(*file)), length};
+            file.reset();
+        }
+#endif
+        if (file && res_.body().empty()) return start_file(std::move(*file));
+#endif
+        if (pending && res_.body().empty()) return start_stream(std::move(*pending));
+
+        keep_alive_ = res_.keep_alive();
+        http::async_write(stream_, res_,
+                          beast::bind_front_handler(&session::on_write, shared_from_this()));
+    }
+
+    /// @brief Write `100 Continue`, then carry on with @p next.
+    void send_continue(void (session::*next)()) {
+        static constexpr std::string_view line = "HTTP/1.1 100 Continue\r\n\r\n";
+        net::async_write(stream_, net::buffer(line),
+                         [self = shared_from_this(), next](beast::error_code ec, std::size_t bytes) {
+                             bulgogi::metrics::add_bytes_out(bytes);
+                             if (ec) return report(ec);
+                             ((*self).*next)();
+                         });
+    }
+
+    /// @brief The body is over its route's limit: answer `413` without reading the rest, and close.
+    void reject_body() {
+        if (parser_) req_.base() = parser_->get().base();  // for the access log
+        parser_.reset();
+        upload_.reset();
+        res_ = {};
+        bulgogi::set_text(res_, "413 Payload Too Large", 413);
+        res_.version(req_.version());
+        bulgogi::metrics::observe(body_metric_, 413, {});
+        respond(nullptr, true);
+    }
+
+    /// @brief A `receive_body` consumer or completion threw: answer like a throwing handler.
+    void fail_body(const std::exception &e) {
+        set_failure(res_, e);
+        res_.version(req_.version());
+        res_.keep_alive(req_.keep_alive());
+    }
+
+    static void set_failure(http::response<http::string_body> &res, const std::exception &e) {
+        bulgogi::detail::stream_slot().reset();
+        res = {};
+#ifndef NDEBUG
+        bulgogi::set_json(res, {{"error", e.what()}}, 400);
+#else
+        (void) e;
+        bulgogi::set_json(res, {{"error", "Internal Server Error"}}, 500);
+#endif
+    }
+
+    /// @brief `REGISTER_STREAMING_BODY` route: call the handler on the headers, then feed it the body.
+    void start_upload(std::uint64_t limit) {
+        upload_ = std::make_unique<upload>(std::move(*parser_));
+        parser_.reset();
+        upload_->parser.body_limit(limit);
+        req_.base() = upload_->parser.get().base();
+
+        res_ = {};
+        const bulgogi::canned_response *canned = handle_request(*route_map_, req_, res_, remote_ip_);
+        auto body = std::exchange(bulgogi::detail::body_slot(), std::nullopt);
+        if (canned || !body) {
+            // Answered without the body, which is left unread: the connection cannot be reused
+            upload_.reset();
+            return respond(canned, true);
+        }
+        // The response is completed by `body->complete`, anything else set up now is dropped
+        bulgogi::detail::stream_slot().reset();
+#if BULGOGI_SENDFILE
+        bulgogi::detail::file_slot().reset();
+#endif
+        upload_->body = std::move(*body);
+        if (expects_continue(req_)) return send_continue(&session::read_upload);
+        read_upload();
+    }
+
+    void read_upload() {
+        auto &body = upload_->parser.get().body();
+        body.data = upload_->buffer.get();
+        body.size = STREAM_BUFFER_SIZE;
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        http::async_read(stream_, buffer_, upload_->parser,
+                         beast::bind_front_handler(&session::on_upload_read, shared_from_this()));
+    }
+
+    /// @brief The buffer is full or the body is complete: pass the piece on and keep reading.
+    void on_upload_read(beast::error_code ec, std::size_t bytes) {
+        bulgogi::metrics::add_bytes_in(bytes);
+        if (ec == http::error::need_buffer) ec = {};
+        if (ec == http::error::body_limit) return reject_body();
+        if (ec) {
+            upload_.reset();
+            return report(ec);
+        }
+        if (g_should_exit) {
+            upload_.reset();
+            return do_close();
+        }
+
+        auto &u = *upload_;
+        const std::size_t n = STREAM_BUFFER_SIZE - u.parser.get().body().size;
+        const bool done = u.parser.is_done();
+        try {
+            if (n) u.body.consumer(std::string_view(u.buffer.get(), n));
+            if (!done) return read_upload();
+            u.body.complete(res_);
+            if (!bulgogi::detail::stream_slot()) res_.prepare_payload();
+        } catch (const std::exception &e) {
+            fail_body(e);
+        }
+        upload_.reset();
+        respond(nullptr, !done);
+    }
+
+    void on_write(beast::error_code ec, std::size_t bytes) {
+        pinned_ = {};
+        count_sent(bytes);
+        log_access();
+        if (ec) return report(ec);
+        if (!keep_alive_ || g_should_exit) return do_close();
+        do_idle_read();
+    }
+
+    void start_stream(bulgogi::detail::pending_stream &&pending) {
+        if (!pending.content_length && req_.version() < 11) {
+            // HTTP/1.0 has no chunked encoding: the body is delimited by closing the connection
+            res_.chunked(false);
+            res_.keep_alive(false);
+        }
+        keep_alive_ = res_.keep_alive();
+        body_stream_ = std::make_unique<body_stream>(std::move(res_.base()), std::move(pending));
+
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        if (req_.method() == http::verb::head) {
+            return http::async_write_header(stream_, body_stream_->sr,
+                                            beast::bind_front_handler(&session::on_stream_done, shared_from_this()));
+        }
+        http::async_write_header(stream_, body_stream_->sr,
+                                 beast::bind_front_handler(&session::on_stream_write, shared_from_this()));
+    }
+
+    /// @brief The previous piece is on the wire: refill the buffer from the producer and send it.
+    void on_stream_write(beast::error_code ec, std::size_t bytes) {
+        count_sent(bytes);
+        if (ec == http::error::need_buffer) ec = {};
+        if (ec) return on_stream_done(ec, 0);
+
+        auto &s = *body_stream_;
+        if (s.sr.is_done()) return on_stream_done({}, 0);
+
+        const auto &length = s.source.content_length;
+        std::size_t n = 0;
+        if (!length || s.sent < *length) {
+            try {
+                n = s.source.producer(s.buffer.get(), STREAM_BUFFER_SIZE);
+            } catch (const std::exception &e) {
+                bulgogi::log::error(std::string("Stream producer error: ") + e.what());
+                return abort_stream();
+            }
+        }
+        if (length && (s.sent + n > *length || (n == 0 && s.sent != *length))) {
+            bulgogi::log::error("Stream producer error: body does not match Content-Length");
+            return abort_stream();
+        }
+        s.sent += n;
+
+        auto &body = s.res.body();
+        body.data = n ? s.buffer.get() : nullptr;
+        body.size = n;
+        body.more = n != 0;
+
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        http::async_write(stream_, s.sr,
+                          beast::bind_front_handler(&session::on_stream_write, shared_from_this()));
+    }
+
+    void on_stream_done(beast::error_code ec, std::size_t bytes) {
+        body_stream_.reset();
+        on_write(ec, bytes);
+    }
+
+    /// @brief The response cannot be completed correctly, so the client must see a broken connection.
+    void abort_stream() {
+        log_access();
+        body_stream_.reset();
+        tcp_stream().close();
+    }
+
+#if BULGOGI_SENDFILE
+    void start_file(bulgogi::detail::pending_file &&file) {
+        keep_alive_ = res_.keep_alive();
+        file_ = std::make_unique<file_transfer>(
+                file_transfer{std::move(file), net::steady_timer(stream_.get_executor())});
+
+        // The body is empty and Content-Length already describes the file, so this writes the headers only
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        http::async_write(stream_, res_,
+                          beast::bind_front_handler(&session::on_file_header, shared_from_this()));
+    }
+
+    void on_file_header(beast::error_code ec, std::size_t bytes) {
+        if (ec) {
+            file_.reset();
+            return on_write(ec, bytes);
+        }
+        count_sent(bytes);
+        boost::system::error_code nb_ec;
+        auto err = tcp_stream().socket().native_non_blocking(true, nb_ec);
+        (void) err;
+        do_sendfile();
+    }
+
+    void do_sendfile() {
+        auto &f = file_->file;
+        const int sock = tcp_stream().socket().native_handle();
+        std::size_t budget = sendfile_turn_bytes;
+
+        while (f.length > 0) {
+            auto offset = static_cast<off_t>(f.offset);
+            const auto n = ::sendfile(sock, f.fd.get(), &offset,
+                                      static_cast<std::size_t>(std::min<std::uint64_t>(f.length, budget)));
+            if (n > 0) {
+                count_sent(static_cast<std::size_t>(n));
+                f.offset += static_cast<std::uint64_t>(n);
+                f.length -= static_cast<std::uint64_t>(n);
+                budget -= static_cast<std::size_t>(n);
+                if (budget == 0 && f.length > 0) {
+                    return net::post(stream_.get_executor(),
+                                     beast::bind_front_handler(&session::do_sendfile, shared_from_this()));
                 }
+                continue;
             }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return wait_writable();
+
+            // 0 means the file shrank under us; either way the response cannot be completed
+            if (!g_should_exit) {
+                bulgogi::log::error(std::string("Sendfile error: ") + (n == 0 ? "file truncated" : std::strerror(errno)));
+            }
+            return abort_file();
         }
 
-        std::cout << "\U0001F44B Server exiting, cleaning up...\n";
+        file_.reset();
+        on_write({}, 0);
+    }
+
+    void wait_writable() {
+        file_->timer.expires_after(std::chrono::seconds(TIMEOUT));
+        file_->timer.async_wait([self = shared_from_this()](beast::error_code ec) {
+            if (ec) return;
+            bulgogi::metrics::count_timeout();
+            self->tcp_stream().socket().cancel();
+        });
+        tcp_stream().socket().async_wait(tcp::socket::wait_write,
+                                    [self = shared_from_this()](beast::error_code ec) {
+                                        self->file_->timer.cancel();
+                                        if (ec) return self->abort_file();  // timed out or peer gone
+                                        self->do_sendfile();
+                                    });
+    }
+
+    void abort_file() {
+        log_access();
+        file_.reset();
+        tcp_stream().close();
+    }
+#endif
+
+#ifdef ENABLE_HTTP2
+    void start_http2() {
+        h2_ = std::make_unique<bulgogi::http2::connection>(bulgogi::http2::connection::handlers{
+                [this](bulgogi::http2::stream &s) { h2_headers(s); },
+                [this](bulgogi::http2::stream &s, std::string_view piece) { h2_data(s, piece); },
+                [this](bulgogi::http2::stream &s) { h2_request(s); },
+                [this](bulgogi::http2::stream &s) { h2_closed(s); }});
+        h2_receive();
+    }
+
+    /// @brief Hand everything buffered to nghttp2, then write what it queued in response.
+    void h2_receive() {
+        const auto data = buffer_.cdata();
+        bulgogi::metrics::add_bytes_in(data.size());
+        const bool ok = h2_->receive({static_cast<const char *>(data.data()), data.size()});
+        buffer_.consume(data.size());
+        if (!ok) bulgogi::log::debug("HTTP/2 protocol error, closing the connection");
+        h2_flush();
+    }
+
+    /// @brief Write queued frames until there are none, then wait for the client.
+    void h2_flush() {
+        if (g_should_exit) h2_->shutdown();
+        const auto out = h2_->pending();
+        if (!out.empty()) {
+            tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+            return net::async_write(stream_, net::buffer(out.data(), out.size()),
+                                    [self = shared_from_this()](beast::error_code ec, std::size_t bytes) {
+                                        bulgogi::metrics::add_bytes_out(bytes);
+                                        if (ec) return report(ec);
+                                        self->h2_flush();
+                                    });
+        }
+        if (!h2_->alive()) return do_close();
+
+        // Nothing in flight: the connection is idle like HTTP/1 keep-alive and may be closed on shutdown
+        idle_ = h2_->open_streams() == 0;
+        tcp_stream().expires_after(std::chrono::seconds(idle_ ? KEEP_ALIVE_TIMEOUT : TIMEOUT));
+        stream_.async_read_some(buffer_.prepare(STREAM_BUFFER_SIZE),
+                                [self = shared_from_this()](beast::error_code ec, std::size_t bytes) {
+                                    self->on_h2_read(ec, bytes);
+                                });
+    }
+
+    void on_h2_read(beast::error_code ec, std::size_t bytes) {
+        const bool idle = std::exchange(idle_, false);
+        if (ec == net::error::operation_aborted && g_should_exit) return h2_flush();  // sends GOAWAY
+        if (ec == beast::error::timeout && !idle) bulgogi::metrics::count_timeout();
+        // Clients drop HTTP/2 connections without ceremony, often with data in flight
+        if (ec == beast::error::timeout || ec == net::error::eof || ec == net::error::connection_reset ||
+            ec == net::error::operation_aborted) return do_close();
+        if (ec) return report(ec);
+        buffer_.commit(bytes);
+        h2_receive();
+    }
+
+    void h2_headers(bulgogi::http2::stream &s) {
+        s.started = std::chrono::steady_clock::now();
+        const auto policy = body_policy(*route_map_, s.req.target());
+        s.metric = policy.metric;
+        s.body_limit = policy.rule.limit;
+        if (s.complete) return;  // no body, h2_request follows
+
+        const auto length = s.req.find(http::field::content_length);
+        if (length != s.req.end()) {
+            std::uint64_t declared = 0;
+            const auto value = length->value();
+            std::from_chars(value.data(), value.data() + value.size(), declared);
+            if (declared > s.body_limit) return h2_reject_body(s);
+        }
+        if (policy.rule.streaming) {
+            http::response<http::string_body> res;
+            const bulgogi::canned_response *canned = handle_request(*route_map_, s.req, res, remote_ip_);
+            auto body = std::exchange(bulgogi::detail::body_slot(), std::nullopt);
+            if (canned || !body) return h2_respond(s, canned, res);  // answered without the body
+            bulgogi::detail::stream_slot().reset();
+#if BULGOGI_SENDFILE
+            bulgogi::detail::file_slot().reset();
+#endif
+            s.upload = std::move(*body);
+        }
+        if (expects_continue(s.req)) h2_->informational(s, 100);
+    }
+
+    void h2_data(bulgogi::http2::stream &s, std::string_view piece) {
+        if (s.upload) {
+            try {
+                s.upload->consumer(piece);
+            } catch (const std::exception &e) {
+                http::response<http::string_body> res;
+                set_failure(res, e);
+                h2_respond(s, nullptr, res);
+            }
+            return;
+        }
+        if (s.req.body().size() + piece.size() > s.body_limit) return h2_reject_body(s);
+        s.req.body().append(piece);
+    }
+
+    void h2_request(bulgogi::http2::stream &s) {
+        if (s.answered) return;
+        http::response<http::string_body> res;
+        if (s.upload) {
+            try {
+                s.upload->complete(res);
+                if (!bulgogi::detail::stream_slot()) res.prepare_payload();
+            } catch (const std::exception &e) {
+                set_failure(res, e);
+            }
+            return h2_respond(s, nullptr, res);
+        }
+
+        const bulgogi::canned_response *canned = handle_request(*route_map_, s.req, res, remote_ip_);
+        if (auto body = std::exchange(bulgogi::detail::body_slot(), std::nullopt); body && !canned) {
+            try {
+                if (!s.req.body().empty()) body->consumer(s.req.body());
+                body->complete(res);
+                if (!bulgogi::detail::stream_slot()) res.prepare_payload();
+            } catch (const std::exception &e) {
+                set_failure(res, e);
+            }
+        }
+        h2_respond(s, canned, res);
+    }
+
+    /// @brief Like `respond`: @p canned if set, otherwise @p res with any streamed or file body.
+    void h2_respond(bulgogi::http2::stream &s, const bulgogi::canned_response *canned,
+                    http::response<http::string_body> &res) {
+        auto pending = std::exchange(bulgogi::detail::stream_slot(), std::nullopt);
+#if BULGOGI_SENDFILE
+        if (auto file = std::exchange(bulgogi::detail::file_slot(), std::nullopt)) {
+            const auto length = file->length;
+            pending = bulgogi::detail::pending_stream{bulgogi::detail::file_producer(std::move(*file)), length};
+        }
+#endif
+        if (canned) {
+            // respond() copies the bytes, so a cache entry need not stay pinned
+            return h2_->respond(s, *canned, bulgogi::response_cache::take_pinned().age());
+        }
+        if (pending && res.body().empty()) return h2_->respond(s, res.base(), std::move(*pending));
+        h2_->respond(s, res);
+    }
+
+    void h2_reject_body(bulgogi::http2::stream &s) {
+        s.upload.reset();
+        http::response<http::string_body> res;
+        bulgogi::set_text(res, "413 Payload Too Large", 413);
+        bulgogi::metrics::observe(s.metric, 413, {});
+        h2_respond(s, nullptr, res);
+    }
+
+    void h2_closed(const bulgogi::http2::stream &s) const {
+        if (!bulgogi::log::access_enabled() || s.status == 0) return;
+        bulgogi::log::access(remote_ip_.str(), s.req.method_string(), bulgogi::route_of(s.req.target()), s.status,
+                             s.sent, std::chrono::steady_clock::now() - s.started);
+    }
+#endif
+
+    void count_sent(std::size_t bytes) {
+        sent_ += bytes;
+        bulgogi::metrics::add_bytes_out(bytes);
+    }
+
+    void log_access() const {
+        if (!bulgogi::log::access_enabled()) return;
+        bulgogi::log::access(remote_ip_.str(), req_.method_string(), bulgogi::route_of(req_.target()), status_, sent_,
+                             std::chrono::steady_clock::now() - started_);
+    }
+
+    void do_close() {
+        boost::system::error_code ec;
+        auto &sock = tcp_stream().socket();
+        if (!sock.is_open()) return;  // already closed by a timeout or cancellation
+
+#ifdef ENABLE_TLS
+        // Send close_notify; the peer's reply, or TIMEOUT, ends the connection
+        tcp_stream().expires_after(std::chrono::seconds(TIMEOUT));
+        return stream_.async_shutdown([self = shared_from_this()](beast::error_code) {
+            boost::system::error_code ignored;
+            auto err = self->tcp_stream().socket().shutdown(tcp::socket::shutdown_send, ignored);
+            (void) err;
+        });
+#endif
+
+        const auto &result = sock.shutdown(tcp::socket::shutdown_send, ec);
+        // Reference of ec, nodiscard
+        if (result && result != boost::asio::error::not_connected) {
+            bulgogi::log::error("Shutdown failed: " + ec.message());
+        }
+    }
+
+    static void report(beast::error_code ec) {
+        if (ec == beast::error::timeout) bulgogi::metrics::count_timeout();
+        if (g_should_exit || ec == http::error::partial_message) return;
+#ifdef ENABLE_TLS
+        if (ec == net::ssl::error::stream_truncated) return;  // peer closed without close_notify
+#endif
+        if (ec == http::error::end_of_stream) {
+            bulgogi::log::debug("Client disconnected");
+        } else {
+            bulgogi::log::error("Session error: " + ec.message());
+        }
+        // Force shutdown silently, the stream is closed with the session
+    }
+};
+
+/**
+ * @brief Close every session that is currently idle on keep-alive; called on shutdown.
+ */
+void close_idle_sessions() {
+    std::vector<std::shared_ptr<session>> sessions;
+    {
+        std::lock_guard lock(session_mutex);
+        sessions.reserve(live_sessions.size());
+        for (const auto &weak: live_sessions) {
+            if (auto s = weak.lock()) sessions.push_back(std::move(s));
+        }
+    }
+    // Dropping the last reference runs ~session(), which takes session_mutex, so do it unlocked
+    for (const auto &s: sessions) s->close_if_idle();
+}
+
+/**
+ * @brief Write @p refusal (a complete preformatted response) to a connection that will not get a
+ *        session, then close it.
+ *
+ * With `ENABLE_TLS` the client expects a handshake, not plaintext, so the connection is only closed.
+ */
+void refuse(tcp::socket &&socket, std::string_view refusal) {
+#ifdef ENABLE_TLS
+    (void) refusal;
+    boost::system::error_code ec;
+    auto err = socket.close(ec);
+    (void) err;
+#else
+    auto sock = std::make_shared<tcp::socket>(std::move(socket));
+    net::async_write(*sock, net::buffer(refusal), [sock](beast::error_code, std::size_t) {
+        boost::system::error_code ec;
+        auto err = sock->shutdown(tcp::socket::shutdown_send, ec);
+        (void) err;
+    });
+#endif
+}
+
+/**
+ * @brief Answer a connection accepted while at `MAX_SESSIONS` with a canned `503` and close it.
+ */
+void reject_overflow(tcp::socket &&socket) {
+    static constexpr std::string_view busy =
+            "HTTP/1.1 503 Service Unavailable\r\n"
+            "Content-Type: text/plain\r\n"
+            "Content-Length: 19\r\n"
+            "Retry-After: 1\r\n"
+            "Connection: close\r\n"
+            "\r\n"
+            "503 Server Too Busy";
+
+    bulgogi::sessions::count_rejected();
+    refuse(std::move(socket), busy);
+}
+
+/// @brief Whether a freshly accepted connection passes `RATE_LIMIT_CONNECTIONS`.
+bool admit_connection(const tcp::socket &socket) {
+    if constexpr (RATE_LIMIT_CONNECTIONS <= 0) {
+        return true;
+    } else {
+        boost::system::error_code ec;
+        const auto endpoint = socket.remote_endpoint(ec);
+        return ec || bulgogi::rate_limit::admit_connection(endpoint.address());
+    }
+}
+
+/**
+ * @brief Accept the next connection on @p acceptor, on its own strand of @p ioc, and re-arm.
+ *
+ * Every accepted socket gets a fresh strand, so independent sessions run in parallel across the
+ * io_context thread pool while each one stays single-threaded.
+ *
+ * A session slot is reserved before the socket is handed to a session. Without
+ * `REJECT_OVERFLOW` the slot is reserved before accepting: when none is free the acceptor parks
+ * itself and `release_session_slot()` resumes it, leaving extra clients in the listen backlog.
+ * With `REJECT_OVERFLOW` the connection is accepted regardless and turned away with a `503`.
+ *
+ * Under `RATE_LIMIT_CONNECTIONS` a client opening connections too fast is turned away with a
+ * `429` before any session exists.
+ */
+void do_accept(tcp::acceptor &acceptor, net::io_context &ioc, const std::shared_ptr<const RouteMap> &route_map) {
+    if (!acceptor.is_open()) return;
+
+#ifndef REJECT_OVERFLOW
+    if (!bulgogi::sessions::try_acquire()) {
+        std::lock_guard lock(session_mutex);
+        if (!bulgogi::sessions::try_acquire()) {
+            parked_accepts.emplace_back([&acceptor, &ioc, route_map] {
+                net::post(acceptor.get_executor(), [&acceptor, &ioc, route_map] {
+                    do_accept(acceptor, ioc, route_map);
+                });
+            });
+            return;
+        }
+    }
+#endif
+
+    acceptor.async_accept(
+            net::make_strand(ioc),
+            [&acceptor, &ioc, route_map](beast::error_code ec, tcp::socket socket) {
+                if (ec == net::error::operation_aborted || !acceptor.is_open()) {
+#ifndef REJECT_OVERFLOW
+                    bulgogi::sessions::release();
+#endif
+                    return;
+                }
+
+                if (ec) {
+                    bulgogi::metrics::count_accept_error();
+                    bulgogi::log::error("Accept error: " + ec.message());
+#ifndef REJECT_OVERFLOW
+                    bulgogi::sessions::release();
+#endif
+                } else if (!admit_connection(socket)) {
+#ifndef REJECT_OVERFLOW
+                    bulgogi::sessions::release();
+#endif
+                    refuse(std::move(socket), bulgogi::rate_limit::connection_refusal());
+                } else {
+#ifdef REJECT_OVERFLOW
+                    if (!bulgogi::sessions::try_acquire()) {
+                        reject_overflow(std::move(socket));
+                        return do_accept(acceptor, ioc, route_map);
+                    }
+#endif
+                    session::start(std::move(socket), route_map);
+                }
+                do_accept(acceptor, ioc, route_map);
+            });
+}
+
+
+#ifdef REUSEPORT
+using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+/// @brief Pin the calling thread to the @p index-th CPU the process may run on; best effort.
+void pin_to_cpu(unsigned index) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) return;
+    index %= static_cast<unsigned>(CPU_COUNT(&allowed));
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed) || index-- != 0) continue;
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(cpu, &one);
+        pthread_setaffinity_np(pthread_self(), sizeof(one), &one);
+        return;
+    }
+}
+#endif
+
+/// @brief Open a listening socket on @p endpoint, shareable with `SO_REUSEPORT` when enabled.
+std::unique_ptr<tcp::acceptor> open_acceptor(net::io_context &ioc, const tcp::endpoint &endpoint) {
+#ifdef REUSEPORT
+    auto acceptor = std::make_unique<tcp::acceptor>(net::make_strand(ioc));
+    acceptor->open(endpoint.protocol());
+    acceptor->set_option(net::socket_base::reuse_address(true));
+    acceptor->set_option(reuse_port(true));
+    acceptor->bind(endpoint);
+    acceptor->listen();
+    return acceptor;
+#else
+    return std::make_unique<tcp::acceptor>(net::make_strand(ioc), endpoint);
+#endif
+}
+
+/**
+ * @brief Build the routes, listen on @p endpoint and serve until `stop_server()` or a signal.
+ *
+ * `main` runs this on `PORT`; `bulgogi_bench` embeds it on an ephemeral loopback port so the load
+ * generator exercises the real session path.
+ *
+ * By default one acceptor feeds a single `io_context` run by every thread. With `REUSEPORT`
+ * each thread gets its own `io_context`, its own `SO_REUSEPORT` acceptor on the same port and its
+ * own CPU, and the kernel spreads incoming connections across them; a connection then stays on
+ * the thread that accepted it.
+ *
+ * @param threads `io_context` threads (shards with `REUSEPORT`), 0 for hardware concurrency.
+ * @param on_listening Called with the bound port once the acceptors are open. When set, it
+ *        replaces the start-up banner (route list and port) and the exit message.
+ * @return Process exit code.
+ */
+int run_server(const tcp::endpoint &endpoint, unsigned threads,
+               const std::function<void(unsigned short)> &on_listening = nullptr) {
+    views::init();
+
+    // Outlive the acceptors and signal set, which are reset before these are destroyed
+    std::vector<std::unique_ptr<net::io_context>> contexts;
+    try {
+        // Malformed patterns or INTERNAL_NETWORKS entries throw here and take the regular error exit below
+        bulgogi::internal_networks();
+        auto route_map = std::make_shared<const RouteMap>(build_route_map());
+#ifdef ENABLE_TLS
+        // An unreadable certificate or key throws here as well
+        global_tls = std::make_unique<net::ssl::context>(bulgogi::tls::make_context());
+#endif
+        if (!on_listening) {
+            std::cout << "Registered routes:" << std::endl;
+            route_map->exact.for_each([](std::string_view name, const Route<views::HandlerFunc> &) {
+                std::cout << name << std::endl;
+            });
+            for (const auto &[pattern, _]: views::pattern_map) {
+                std::cout << "/" << pattern << std::endl;
+            }
+            for (const auto &[prefix, root]: views::static_map) {
+                std::cout << "/" << prefix << (prefix.empty() ? "*" : "/*") << " -> " << root << std::endl;
+            }
+        }
+
+        bulgogi::log::start();
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+#ifdef REUSEPORT
+        const unsigned shards = threads;
+#else
+        const unsigned shards = 1;
+#endif
+
+        tcp::endpoint bound = endpoint;
+        for (unsigned i = 0; i < shards; ++i) {
+            contexts.push_back(std::make_unique<net::io_context>(static_cast<int>(threads / shards)));
+            global_acceptors.push_back(open_acceptor(*contexts.back(), bound));
+            bound.port(global_acceptors.back()->local_endpoint().port());  // port 0: the others join the first
+        }
+
+        global_signals = std::make_unique<net::signal_set>(*contexts.front(), SIGINT, SIGTERM);
+        global_signals->async_wait([](beast::error_code ec, int) {
+            if (ec) return;  // cancelled by stop_server()
+            g_should_exit = true;
+            stop_server();
+        });
+
+        for (unsigned i = 0; i < shards; ++i) {
+            do_accept(*global_acceptors[i], *contexts[i], route_map);
+        }
+
+        if (on_listening) {
+            on_listening(bound.port());
+        } else {
+#ifdef ENABLE_TLS
+            std::cout << "HTTPS";
+#else
+            std::cout << "HTTP";
+#endif
+            std::cout << " server running on port " << bound.port() << " with " << threads << " threads";
+            if (shards > 1) std::cout << " (" << shards << " SO_REUSEPORT shards)";
+            std::cout << "..." << std::endl;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (unsigned i = 1; i < threads; ++i) {
+            net::io_context &ioc = *contexts[i % shards];
+#ifdef REUSEPORT
+            workers.emplace_back([&ioc, i] {
+                pin_to_cpu(i);
+                ioc.run();
+            });
+#else
+            workers.emplace_back([&ioc] { ioc.run(); });
+#endif
+        }
+#ifdef REUSEPORT
+        pin_to_cpu(0);
+#endif
+        contexts.front()->run();
+
+        for (auto &worker: workers) {
+            worker.join();
+        }
+
+        global_signals.reset();
+        global_acceptors.clear();
+        bulgogi::log::stop();
+
+        if (!on_listening) std::cout << "\U0001F44B Server exiting, cleaning up...\n";
         views::atexit();
 
     } catch (std::exception &e) {
+        global_signals.reset();
+        global_acceptors.clear();
+        bulgogi::log::stop();
         std::cerr << "Error: " << e.what() << std::endl;
         views::atexit();
         // Fallback to clean-up if exception occurs
@@ -213,3 +1721,9 @@ int main() {
 
     return 0;
 }
+
+#ifndef BULGOGI_NO_MAIN
+int main() {
+    return run_server(tcp::endpoint{tcp::v4(), PORT}, THREADS);
+}
+#endif